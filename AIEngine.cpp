@@ -5,6 +5,7 @@
 #include <sstream>
 #include <cmath>
 #include <climits>
+#include <thread>
 
 // 棋子价值表
 const int AIEngine::PIECE_VALUES[15] = {
@@ -25,24 +26,42 @@ const int AIEngine::PIECE_VALUES[15] = {
     -100    // BLACK_PAWN
 };
 
-// 位置价值表（简化版本）
-const int AIEngine::POSITION_VALUES[15][10][9] = {};
-
-// Zobrist哈希表
-uint64_t AIEngine::zobristTable[10][9][15];
-bool AIEngine::zobristInitialized = false;
-
 AIEngine::AIEngine() 
-    : difficulty(AI_MEDIUM), maxDepth(4), timeLimit(5.0), randomnessFactor(0.1),
+    : difficulty(AI_MEDIUM),
       thinkingState(AI_IDLE), shouldStop(false), nodesSearched(0), 
-      lastThinkingTime(0.0), debugMode(false), randomGenerator(std::chrono::steady_clock::now().time_since_epoch().count())
+      lastThinkingTime(0.0), debugMode(false),
+      evalCache(EVAL_CACHE_ENTRIES), pawnCache(PAWN_CACHE_ENTRIES), randomGenerator(std::chrono::steady_clock::now().time_since_epoch().count())
 {
-    if (!zobristInitialized) {
-        initializeZobrist();
+    initReductionTable();
+}
+
+void AIEngine::setReductionFactors(double base, double divisor) {
+    settings.reductionBase = base;
+    settings.reductionDivisor = divisor;
+}
+
+void AIEngine::applySettings() {
+    // 在搜索线程启动前调用，衰减表随参数一同更新
+    params = settings;
+    initReductionTable();
+}
+
+void AIEngine::initReductionTable() {
+    // 衰减量随剩余深度和走法序号对数增长
+    for (int depth = 0; depth < REDUCTION_TABLE_SIZE; depth++) {
+        for (int index = 0; index < REDUCTION_TABLE_SIZE; index++) {
+            if (depth == 0 || index == 0) {
+                reductionTable[depth][index] = 0;
+                continue;
+            }
+            double reduction = params.reductionBase + std::log(depth) * std::log(index) / params.reductionDivisor;
+            reductionTable[depth][index] = std::max(0, static_cast<int>(reduction));
+        }
     }
 }
 
 AIEngine::~AIEngine() {
+    stopThinking();
 }
 
 void AIEngine::setDifficulty(AIDifficulty diff) {
@@ -51,35 +70,43 @@ void AIEngine::setDifficulty(AIDifficulty diff) {
     // 根据难度设置参数
     switch (difficulty) {
         case AI_EASY:
-            maxDepth = 2;
-            randomnessFactor = 0.3;
-            timeLimit = 1.0;
+            settings.maxDepth = 2;
+            settings.randomnessFactor = 0.3;
+            settings.timeLimit = 1.0;
             break;
         case AI_MEDIUM:
-            maxDepth = 4;
-            randomnessFactor = 0.1;
-            timeLimit = 3.0;
+            settings.maxDepth = 4;
+            settings.randomnessFactor = 0.1;
+            settings.timeLimit = 3.0;
             break;
         case AI_HARD:
-            maxDepth = 6;
-            randomnessFactor = 0.05;
-            timeLimit = 5.0;
+            settings.maxDepth = 6;
+            settings.randomnessFactor = 0.05;
+            settings.timeLimit = 5.0;
             break;
         case AI_EXPERT:
-            maxDepth = 8;
-            randomnessFactor = 0.0;
-            timeLimit = 10.0;
+            settings.maxDepth = 8;
+            settings.randomnessFactor = 0.0;
+            settings.timeLimit = 10.0;
             break;
     }
 }
 
 Move AIEngine::getBestMove(const ChessEngine& engine, bool forRed) {
+    shouldStop = false;
+    applySettings();
+    return searchBestMove(engine, forRed);
+}
+
+Move AIEngine::searchBestMove(const ChessEngine& engine, bool forRed) {
     debugPrint("开始AI思考...");
     
-    // 重置统计信息
+    // 重置统计信息（停止标志由调用者设置，以免覆盖启动后立即到来的停止请求）
     nodesSearched = 0;
-    searchStartTime = std::chrono::steady_clock::now();
-    shouldStop = false;
+    cacheStats = EvalCacheStats();
+    currentResult = EvaluationResult();
+    timeManager.start(params.timeControl, params.timeLimit);
+    transpositionTable.newSearch();
     
     // 检查开局库
     Move openingMove;
@@ -96,8 +123,8 @@ Move AIEngine::getBestMove(const ChessEngine& engine, bool forRed) {
     }
     
     // 生成所有合法走法
-    ChessEngine tempEngine = engine;
-    std::vector<Move> legalMoves = tempEngine.generateLegalMoves(forRed);
+    MoveList legalMoves;
+    engine.generateLegalMoves(forRed, legalMoves);
     
     if (legalMoves.empty()) {
         debugPrint("没有合法走法");
@@ -109,241 +136,787 @@ Move AIEngine::getBestMove(const ChessEngine& engine, bool forRed) {
         return legalMoves[0];
     }
     
-    Move bestMove;
-    int bestScore = forRed ? INT_MIN : INT_MAX;
+    // Lazy SMP：所有线程从同一根局面出发各自迭代加深，通过共享置换表互相借力
+    searchThreads.clear();
+    for (int i = 0; i < params.threadCount; i++) {
+        searchThreads.emplace_back(new SearchThread());
+        searchThreads[i]->id = i;
+        searchThreads[i]->engine = engine;
+        searchThreads[i]->engine.refreshMaterialScore();   // 价值表可能在局面建立后重新加载过
+    }
     
-    // 迭代加深搜索
-    for (int depth = 1; depth <= maxDepth && !isTimeUp(); depth++) {
-        debugPrint("搜索深度: " + std::to_string(depth));
+    std::vector<std::thread> helpers;
+    for (int i = 1; i < params.threadCount; i++) {
+        helpers.emplace_back(&AIEngine::iterativeDeepening, this, std::ref(*searchThreads[i]), std::cref(legalMoves), forRed);
+    }
+    iterativeDeepening(*searchThreads[0], legalMoves, forRed);
+    
+    // 主线程结束后通知辅助线程停止
+    shouldStop = true;
+    for (std::thread& helper : helpers) {
+        helper.join();
+    }
+    
+    // 采用完成深度最大的线程的结果，深度相同时以主线程为准
+    const SearchThread* bestThread = searchThreads[0].get();
+    currentResult.threadNodes.clear();
+    for (const auto& thread : searchThreads) {
+        if (thread->completedDepth > bestThread->completedDepth && thread->bestMove.isValid()) {
+            bestThread = thread.get();
+        }
+        currentResult.threadNodes.push_back(thread->nodes);
+        cacheStats.add(thread->cacheStats);
+    }
+    nodesSearched = totalNodes();
+    
+    Move bestMove = bestThread->bestMove;
+    int bestScore = bestThread->bestScore;
+    
+    // 时间将尽时可能连第一个根节点走法都没有搜完，退而采用排序最前的走法
+    if (!bestMove.isValid()) {
+        orderMoves(legalMoves, engine, Move());
+        bestMove = legalMoves[0];
+    }
+    currentResult.bestMove = bestMove;
+    currentResult.score = bestScore;
+    currentResult.pv = bestThread->pv;
+    currentResult.lines = searchThreads[0]->lines;   // 只有主线程计算多主变
+    currentResult.depth = bestThread->completedDepth;
+    currentResult.nodesSearched = nodesSearched;
+    
+    // 降低棋力：取所用线程最近一次完成迭代中评分下界不低于最佳评分减余量的根节点走法随机选择，
+    // 下界来自根节点搜索本身（见searchRoot），不另做搜索
+    if (params.randomnessFactor > 0.0 && bestThread->completedDepth > 0 && std::abs(bestScore) < MATE_BOUND) {
+        int threshold = bestScore - static_cast<int>(100 * params.randomnessFactor);
+        std::vector<Move> candidates(1, bestMove);
+        for (const auto& entry : bestThread->rootScores) {
+            if (entry.first >= threshold && PackedMove(entry.second) != PackedMove(bestMove)) {
+                candidates.push_back(entry.second);
+            }
+        }
         
-        int alpha = INT_MIN;
-        int beta = INT_MAX;
-        Move currentBestMove;
-        int currentBestScore = forRed ? INT_MIN : INT_MAX;
+        std::uniform_int_distribution<> dist(0, static_cast<int>(candidates.size()) - 1);
+        bestMove = candidates[dist(randomGenerator)];
+    }
+    
+    // 记录思考时间
+    lastThinkingTime = timeManager.elapsed();
+    currentResult.timeUsed = lastThinkingTime;
+    
+    debugPrint("AI思考完成，用时: " + std::to_string(lastThinkingTime) + "秒");
+    debugPrint("搜索节点数: " + std::to_string(nodesSearched));
+    
+    return bestMove;
+}
+
+void AIEngine::iterativeDeepening(SearchThread& thread, const MoveList& rootMoves, bool forRed) {
+    ChessEngine& engine = thread.engine;
+    MoveList legalMoves = rootMoves;
+    
+    // 负极大值搜索以走棋方为准，确保根局面的走棋方与forRed一致
+    engine.setRedTurn(forRed);
+    
+    // 辅助线程错开起始深度，使各线程尽量不在同一深度上重复搜索
+    int startDepth = 1 + thread.id % 2;
+    
+    // 多主变只由主线程计算，辅助线程只需填充置换表
+    int lineCount = thread.id == 0 ? std::min(params.multiPV, legalMoves.size()) : 1;
+    
+    // 迭代加深搜索
+    for (int depth = startDepth; depth <= params.maxDepth && !isTimeUp(); depth++) {
+        if (thread.id == 0) {
+            debugPrint("搜索深度: " + std::to_string(depth));
+        }
         
-        // 走法排序
-        orderMoves(legalMoves, tempEngine, bestMove);
+        // 走法排序，上一轮的各条变例依次排在最前
+        orderMoves(legalMoves, engine, thread.bestMove);
+        for (int i = static_cast<int>(thread.lines.size()) - 1; i >= 0; i--) {
+            moveToIndex(legalMoves, 0, thread.lines[i].move);
+        }
         
-        for (const Move& move : legalMoves) {
-            if (isTimeUp()) break;
-            
-            // 尝试走法
-            if (!tempEngine.makeMove(move)) continue;
-            
-            // 搜索
-            int score = alphaBeta(tempEngine, depth - 1, alpha, beta, !forRed);
-            
-            // 撤销走法
-            tempEngine.undoMove();
+        // 逐条搜索变例，每条变例只在尚未选出的走法中寻找最佳
+        thread.rootDepth = depth;
+        thread.iterationScores.clear();
+        std::vector<SearchLine> lines;
+        bool completed = true;
+        for (int pvIndex = 0; pvIndex < lineCount && completed; pvIndex++) {
+            int previousScore = pvIndex < static_cast<int>(thread.lines.size()) ? thread.lines[pvIndex].score
+                                                                                 : thread.bestScore;
+            SearchLine line;
+            completed = searchRootLine(thread, legalMoves, pvIndex, depth, previousScore, line);
+            if (!line.move.isValid()) break;
             
-            // 更新最佳走法
-            if (forRed) {
-                if (score > currentBestScore) {
-                    currentBestScore = score;
-                    currentBestMove = move;
-                }
-                alpha = std::max(alpha, score);
-            } else {
-                if (score < currentBestScore) {
-                    currentBestScore = score;
-                    currentBestMove = move;
-                }
-                beta = std::min(beta, score);
+            moveToIndex(legalMoves, pvIndex, line.move);
+            lines.push_back(line);
+        }
+        
+        // 中途停止时，已得到的第一条变例仍比上一轮的结果可靠
+        if (!completed) {
+            if (!lines.empty()) {
+                thread.bestMove = lines[0].move;
+                thread.bestScore = lines[0].score;
+                thread.pv = lines[0].pv;
             }
-            
-            if (beta <= alpha) break; // Alpha-Beta剪枝
+            break;
         }
         
-        // 如果没有超时，更新最佳走法
-        if (!isTimeUp()) {
-            bestMove = currentBestMove;
-            bestScore = currentBestScore;
+        // 后搜的变例可能因搜索不稳定而评分更高
+        std::stable_sort(lines.begin(), lines.end(),
+                         [](const SearchLine& a, const SearchLine& b) { return a.score > b.score; });
+        
+        bool bestMoveChanged = PackedMove(lines[0].move) != PackedMove(thread.bestMove);
+        thread.bestMove = lines[0].move;
+        thread.bestScore = lines[0].score;
+        thread.pv = lines[0].pv;
+        thread.lines = lines;
+        thread.rootScores.swap(thread.iterationScores);
+        thread.completedDepth = depth;
+        transpositionTable.store(computeHash(engine), scoreToTT(thread.bestScore, 0), depth,
+                                 TranspositionEntry::EXACT, PackedMove(thread.bestMove));
+        
+        // 主线程负责报告进度，并在软时限到达后不再开始新的迭代
+        if (thread.id == 0) {
+            reportProgress(thread);
+            timeManager.onIterationComplete(bestMoveChanged);
+            if (timeManager.shouldStopAfterIteration()) break;
         }
     }
+}
+
+bool AIEngine::searchRootLine(SearchThread& thread, const MoveList& rootMoves, int firstIndex, int depth,
+                              int previousScore, SearchLine& line) {
+    // 期望窗口：以上一次迭代的评分为中心，失败时逐步放宽
+    int delta = ASPIRATION_WINDOW;
+    int alpha = -INFINITE_SCORE;
+    int beta = INFINITE_SCORE;
+    if (thread.completedDepth >= 3 && std::abs(previousScore) < MATE_BOUND) {
+        alpha = std::max(previousScore - delta, -INFINITE_SCORE);
+        beta = std::min(previousScore + delta, INFINITE_SCORE);
+    }
     
-    // 添加随机性
-    if (randomnessFactor > 0.0) {
-        std::vector<Move> goodMoves;
-        int threshold = bestScore - static_cast<int>(100 * randomnessFactor);
+    while (true) {
+        Move bestMove;
+        int score = searchRoot(thread, rootMoves, firstIndex, depth, alpha, beta, bestMove);
         
-        for (const Move& move : legalMoves) {
-            ChessEngine testEngine = tempEngine;
-            if (testEngine.makeMove(move)) {
-                int score = evaluatePosition(testEngine, forRed);
-                if (forRed ? (score >= threshold) : (score <= threshold)) {
-                    goodMoves.push_back(move);
-                }
+        // 中途停止时，只有已完整搜索且超过alpha的走法可用
+        if (isTimeUp()) {
+            if (bestMove.isValid() && score > alpha) {
+                line.move = bestMove;
+                line.score = score;
+                line.pv = thread.rootPV();
             }
+            return false;
         }
         
-        if (!goodMoves.empty()) {
-            std::uniform_int_distribution<> dist(0, static_cast<int>(goodMoves.size()) - 1);
-            bestMove = goodMoves[dist(randomGenerator)];
+        if (score <= alpha) {
+            beta = (alpha + beta) / 2;
+            alpha = std::max(score - delta, -INFINITE_SCORE);
+        } else if (score >= beta) {
+            beta = std::min(score + delta, INFINITE_SCORE);
+        } else {
+            line.move = bestMove;
+            line.score = score;
+            line.pv = thread.rootPV();
+            return true;
         }
+        delta *= 2;
     }
+}
+
+int AIEngine::searchRoot(SearchThread& thread, const MoveList& rootMoves, int firstIndex, int depth, int alpha, int beta,
+                         Move& bestMove) {
+    ChessEngine& engine = thread.engine;
+    int bestScore = -INFINITE_SCORE;
+    bool firstMove = true;
+    thread.pvLength[0] = 0;
     
-    // 记录思考时间
-    auto endTime = std::chrono::steady_clock::now();
-    lastThinkingTime = std::chrono::duration<double>(endTime - searchStartTime).count();
+    // 降低棋力时零窗口检验的下沿放低余量，使余量内的走法也得到可靠的下界
+    int weakeningMargin = static_cast<int>(100 * params.randomnessFactor);
     
-    debugPrint("AI思考完成，用时: " + std::to_string(lastThinkingTime) + "秒");
-    debugPrint("搜索节点数: " + std::to_string(nodesSearched));
+    for (int i = firstIndex; i < rootMoves.size(); i++) {
+        const Move& move = rootMoves[i];
+        if (isTimeUp()) break;
+        
+        // 尝试走法（走法来自合法走法生成器，无需再次验证）
+        UndoInfo undo;
+        engine.makeMoveUnchecked(move, undo);
+        thread.moveStack[0] = undo.move;
+        
+        // 第一个走法用完整窗口，其余先用零窗口验证，超出alpha时再完整重搜
+        int score;
+        int lowerEdge = alpha;
+        if (firstMove) {
+            score = -alphaBeta(thread, depth - 1, -beta, -alpha, 1);
+        } else {
+            lowerEdge = std::max(alpha - weakeningMargin, -INFINITE_SCORE);
+            score = -alphaBeta(thread, depth - 1, -lowerEdge - 1, -lowerEdge, 1);
+            if (score > alpha && score < beta) {
+                lowerEdge = alpha;
+                score = -alphaBeta(thread, depth - 1, -beta, -alpha, 1);
+            }
+        }
+        firstMove = false;
+        
+        // 撤销走法
+        engine.unmakeMove(undo);
+        
+        // 被中断的子树评分不可靠
+        if (isTimeUp()) break;
+        
+        // 超过检验下沿的评分是可靠的下界，不超过的只是上界，不能用于挑选
+        if (score > lowerEdge) {
+            thread.recordRootScore(move, score);
+        }
+        
+        if (score > bestScore) {
+            bestScore = score;
+            bestMove = move;
+            thread.updatePV(0, undo.move);
+        }
+        if (score > alpha) {
+            alpha = score;
+            if (alpha >= beta) break;
+        }
+    }
     
-    return bestMove;
+    return bestScore;
 }
 
-int AIEngine::alphaBeta(ChessEngine& engine, int depth, int alpha, int beta, bool maximizing) {
-    nodesSearched++;
+int AIEngine::alphaBeta(SearchThread& thread, int depth, int alpha, int beta, int ply, bool allowNull) {
+    ChessEngine& engine = thread.engine;
+    thread.countNode();
+    checkTime(thread);
+    thread.pvLength[ply] = ply;
+    
+    // 重复局面：长将、长捉一方判负，其余作和
+    RepetitionType repetition = engine.getRepetitionType();
+    if (repetition != REPETITION_NONE) {
+        return repetitionScore(repetition, ply);
+    }
     
-    if (depth == 0 || isTimeUp()) {
-        return quiescenceSearch(engine, alpha, beta, maximizing);
+    if (depth <= 0 || isTimeUp()) {
+        return quiescenceSearch(thread, alpha, beta, ply);
     }
     
-    std::vector<Move> moves = engine.generateLegalMoves(maximizing);
+    if (ply >= MAX_PLY - 1) {
+        return evaluateLazy(engine, engine.isRedTurn(), -INFINITE_SCORE, INFINITE_SCORE, &thread.cacheStats);
+    }
+    
+    // 查询置换表：非PV节点深度足够时直接截断，否则取出最佳走法用于排序
+    bool pvNode = beta - alpha > 1;
+    uint64_t hash = computeHash(engine);
+    PackedMove hashMove;
+    TranspositionEntry entry;
+    if (transpositionTable.probe(hash, entry)) {
+        hashMove = entry.bestMove;
+        if (!pvNode && entry.depth >= depth) {
+            int ttScore = scoreFromTT(entry.score, ply);
+            if (entry.type == TranspositionEntry::EXACT) return ttScore;
+            if (entry.type == TranspositionEntry::LOWER_BOUND && ttScore >= beta) return ttScore;
+            if (entry.type == TranspositionEntry::UPPER_BOUND && ttScore <= alpha) return ttScore;
+        }
+    }
+    
+    bool redToMove = engine.isRedTurn();
+    bool inCheck = engine.isInCheck(redToMove);
+    
+    // 静态评估只在非PV且未被将军的节点上用于剪枝
+    bool canPrune = !pvNode && !inCheck && std::abs(alpha) < MATE_BOUND && std::abs(beta) < MATE_BOUND;
+    int staticEval = canPrune ? evaluateLazy(engine, redToMove, -INFINITE_SCORE, INFINITE_SCORE, &thread.cacheStats) : 0;
+    
+    if (canPrune && depth <= PRUNING_MAX_DEPTH) {
+        // 反向无益裁剪：静态评估减去余量仍高于beta，直接截断
+        if (params.reverseFutilityMargin > 0 && staticEval - params.reverseFutilityMargin * depth >= beta) {
+            return staticEval - params.reverseFutilityMargin * depth;
+        }
+        
+        // 剃刀：静态评估远低于alpha时只做静态搜索确认
+        if (params.razorMargin > 0 && depth <= 2 && staticEval + params.razorMargin * depth < alpha) {
+            int razorScore = quiescenceSearch(thread, alpha, beta, ply);
+            if (razorScore < alpha) return razorScore;
+        }
+    }
+    
+    // 空着裁剪：让对方连走一步仍不低于beta，说明当前局面足够好，可以直接截断
+    if (allowNull && canPrune && depth >= NULL_MOVE_MIN_DEPTH &&
+        canTryNullMove(engine, redToMove) && staticEval >= beta) {
+        int reduction = depth > 6 ? 3 : 2;
+        
+        engine.makeNullMove();
+        thread.moveStack[ply] = PackedMove();
+        int nullScore = -alphaBeta(thread, depth - 1 - reduction, -beta, -beta + 1, ply + 1, false);
+        engine.unmakeNullMove();
+        
+        if (isTimeUp()) return 0;
+        
+        if (nullScore >= beta) {
+            // 空着搜索得到的将杀分数不可靠
+            if (nullScore >= MATE_BOUND) nullScore = beta;
+            
+            // 深度较大时用禁止空着的浅层搜索验证，防止漏掉等着局面
+            if (depth < NULL_MOVE_VERIFY_DEPTH) return nullScore;
+            int verifyScore = alphaBeta(thread, depth - 1 - reduction, beta - 1, beta, ply, false);
+            if (verifyScore >= beta) return nullScore;
+        }
+    }
+    
+    MoveList moves;
+    engine.generateLegalMoves(redToMove, moves);
     if (moves.empty()) {
         // 无子可走，判断是否被将军
-        if (engine.isInCheck(maximizing)) {
-            return maximizing ? -10000 + depth : 10000 - depth; // 被将死
+        if (inCheck) {
+            return -MATE_SCORE + ply; // 被将死，越早被将死分数越低
         } else {
             return 0; // 和棋
         }
     }
     
-    orderMoves(moves, engine, Move());
+    // 分阶段取出走法：置换表走法、好的吃子、杀手与应着、历史分高的安静走法、坏的吃子
+    PackedMove previousMove = thread.moveStack[ply - 1];
+    MovePicker picker(engine, moves, hashMove.toMove(), &thread.heuristics, ply, previousMove);
+    MoveList quietsSearched;
+    
+    // 无益裁剪：静态评估加余量仍达不到alpha时，不将军的安静走法不再搜索
+    int futilityValue = staticEval + params.futilityMargin * depth;
+    bool futilityPruning = canPrune && params.futilityMargin > 0 && depth <= PRUNING_MAX_DEPTH && futilityValue <= alpha;
     
-    if (maximizing) {
-        int maxEval = INT_MIN;
-        for (const Move& move : moves) {
-            if (isTimeUp()) break;
+    int originalAlpha = alpha;
+    int bestScore = -INFINITE_SCORE;
+    Move bestMove;
+    int moveIndex = 0;
+    Move move;
+    while (picker.next(move)) {
+        if (isTimeUp()) break;
+        
+        bool quiet = !isCapture(move, engine);
+        bool givesCheck = isCheck(move, engine);
+        
+        if (futilityPruning && moveIndex > 0 && quiet && !givesCheck) {
+            bestScore = std::max(bestScore, futilityValue);
+            continue;
+        }
+        
+        // 将军延伸：将军走法多搜一层，总延伸不超过根深度
+        int newDepth = depth - 1;
+        if (givesCheck && ply < 2 * thread.rootDepth) {
+            newDepth++;
+        }
+        
+        UndoInfo undo;
+        engine.makeMoveUnchecked(move, undo);
+        thread.moveStack[ply] = undo.move;
+        
+        // 主要变例搜索：后续走法先用零窗口证明不优于当前最佳
+        int score;
+        if (moveIndex == 0) {
+            score = -alphaBeta(thread, newDepth, -beta, -alpha, ply + 1);
+        } else {
+            // 后期走法衰减：排在后面的安静走法先做浅层搜索，超出alpha时再恢复深度
+            int reduction = 0;
+            if (params.lateMoveReductions && depth >= LMR_MIN_DEPTH && quiet && !inCheck && !givesCheck) {
+                reduction = reductionTable[std::min(depth, REDUCTION_TABLE_SIZE - 1)]
+                                          [std::min(moveIndex, REDUCTION_TABLE_SIZE - 1)];
+                if (pvNode) reduction--;
+                reduction = std::max(0, std::min(reduction, depth - 2));
+            }
             
-            if (engine.makeMove(move)) {
-                int eval = alphaBeta(engine, depth - 1, alpha, beta, false);
-                engine.undoMove();
-                
-                maxEval = std::max(maxEval, eval);
-                alpha = std::max(alpha, eval);
-                
-                if (beta <= alpha) break;
+            score = -alphaBeta(thread, newDepth - reduction, -alpha - 1, -alpha, ply + 1);
+            if (reduction > 0 && score > alpha) {
+                score = -alphaBeta(thread, newDepth, -alpha - 1, -alpha, ply + 1);
+            }
+            if (score > alpha && score < beta) {
+                score = -alphaBeta(thread, newDepth, -beta, -alpha, ply + 1);
             }
         }
-        return maxEval;
-    } else {
-        int minEval = INT_MAX;
-        for (const Move& move : moves) {
-            if (isTimeUp()) break;
-            
-            if (engine.makeMove(move)) {
-                int eval = alphaBeta(engine, depth - 1, alpha, beta, true);
-                engine.undoMove();
-                
-                minEval = std::min(minEval, eval);
-                beta = std::min(beta, eval);
-                
-                if (beta <= alpha) break;
+        moveIndex++;
+        
+        engine.unmakeMove(undo);
+        
+        if (score > bestScore) {
+            bestScore = score;
+            bestMove = move;
+        }
+        if (score > alpha) {
+            alpha = score;
+            if (pvNode) {
+                thread.updatePV(ply, undo.move);
+            }
+            if (alpha >= beta) {
+                // 安静走法产生截断时更新杀手、应着与历史表
+                if (quiet) {
+                    thread.heuristics.updateQuietCutoff(redToMove, ply, move, previousMove, depth,
+                                                        quietsSearched.begin(), quietsSearched.size());
+                }
+                break;
             }
         }
-        return minEval;
+        if (quiet) {
+            quietsSearched.push_back(move);
+        }
+    }
+    
+    // 超时中断的结果不完整，不写入置换表
+    if (!isTimeUp()) {
+        TranspositionEntry::NodeType type = TranspositionEntry::EXACT;
+        if (bestScore <= originalAlpha) {
+            type = TranspositionEntry::UPPER_BOUND;
+        } else if (bestScore >= beta) {
+            type = TranspositionEntry::LOWER_BOUND;
+        }
+        transpositionTable.store(hash, scoreToTT(bestScore, ply), depth, type, PackedMove(bestMove));
     }
+    
+    return bestScore;
 }
 
-int AIEngine::quiescenceSearch(ChessEngine& engine, int alpha, int beta, bool maximizing, int qDepth) {
-    nodesSearched++;
+int AIEngine::quiescenceSearch(SearchThread& thread, int alpha, int beta, int ply, int qDepth) {
+    ChessEngine& engine = thread.engine;
+    thread.countNode();
+    checkTime(thread);
+    thread.pvLength[ply] = ply;   // 主要变例不延伸到静态搜索
     
-    int standPat = evaluatePosition(engine, maximizing);
+    // 静态评估以走棋方为准，远在窗口之外时只算子力
+    bool redToMove = engine.isRedTurn();
+    int standPat = evaluateLazy(engine, redToMove, alpha, beta, &thread.cacheStats);
     
-    if (qDepth > 4) return standPat;
+    if (qDepth > 4 || ply >= MAX_PLY - 1) return standPat;
     
-    if (maximizing) {
-        if (standPat >= beta) return beta;
+    // 被将军时不能停着，必须搜索全部应将走法
+    bool inCheck = engine.isInCheck(redToMove);
+    int bestScore = -INFINITE_SCORE;
+    if (!inCheck) {
+        if (standPat >= beta) return standPat;
         alpha = std::max(alpha, standPat);
+        bestScore = standPat;
+    }
+    
+    MoveList moves;
+    if (inCheck) {
+        engine.generateLegalMoves(redToMove, moves);
+        if (moves.empty()) return -MATE_SCORE + ply;
     } else {
-        if (standPat <= alpha) return alpha;
-        beta = std::min(beta, standPat);
+        engine.generateLegalCaptures(redToMove, moves);
     }
     
-    std::vector<Move> captures;
-    std::vector<Move> allMoves = engine.generateLegalMoves(maximizing);
+    MovePicker picker(engine, moves, Move());
     
-    for (const Move& move : allMoves) {
-        if (isCapture(move, engine)) {
-            captures.push_back(move);
+    Move move;
+    while (picker.next(move)) {
+        // 静态交换评估亏子的吃子排在最后，遇到即可停止（应将时除外）
+        if (!inCheck && picker.pickedBadCapture()) break;
+        
+        UndoInfo undo;
+        engine.makeMoveUnchecked(move, undo);
+        int score = -quiescenceSearch(thread, -beta, -alpha, ply + 1, qDepth + 1);
+        engine.unmakeMove(undo);
+        
+        if (score > bestScore) {
+            bestScore = score;
+            if (score > alpha) {
+                alpha = score;
+                if (alpha >= beta) return bestScore;
+            }
         }
     }
     
-    if (captures.empty()) return standPat;
-    
-    orderMoves(captures, engine, Move());
-    
-    for (const Move& move : captures) {
-        if (engine.makeMove(move)) {
-            int score = quiescenceSearch(engine, alpha, beta, !maximizing, qDepth + 1);
-            engine.undoMove();
+    // 静态搜索第一层再尝试少量不吃子的将军走法，以发现短程杀棋
+    if (!inCheck && qDepth == 0) {
+        MoveList quietMoves;
+        engine.generateQuietCheckCandidates(redToMove, quietMoves);
+        
+        int checksSearched = 0;
+        for (const Move& quietMove : quietMoves) {
+            if (checksSearched >= MAX_QUIESCENCE_CHECKS) break;
+            if (!isCheck(quietMove, engine)) continue;
+            checksSearched++;
+            
+            UndoInfo undo;
+            engine.makeMoveUnchecked(quietMove, undo);
+            int score = -quiescenceSearch(thread, -beta, -alpha, ply + 1, qDepth + 1);
+            engine.unmakeMove(undo);
             
-            if (maximizing) {
-                if (score >= beta) return beta;
-                alpha = std::max(alpha, score);
-            } else {
-                if (score <= alpha) return alpha;
-                beta = std::min(beta, score);
+            if (score > bestScore) {
+                bestScore = score;
+                if (score > alpha) {
+                    alpha = score;
+                    if (alpha >= beta) break;
+                }
             }
         }
     }
     
-    return maximizing ? alpha : beta;
+    return bestScore;
+}
+
+int AIEngine::repetitionScore(RepetitionType type, int ply) {
+    switch (type) {
+        case REPETITION_PERPETUAL_CHECK:
+        case REPETITION_PERPETUAL_CHASE:
+            return -MATE_SCORE + ply;
+        case REPETITION_OPPONENT_CHECK:
+        case REPETITION_OPPONENT_CHASE:
+            return MATE_SCORE - ply;
+        default:
+            return 0;
+    }
+}
+
+bool AIEngine::canTryNullMove(const ChessEngine& engine, bool red) const {
+    // 只剩将、士、象、兵时容易出现等着（zugzwang），此时不做空着裁剪
+    if (red) {
+        return (engine.getPieceBitboard(RED_ROOK) | engine.getPieceBitboard(RED_KNIGHT) |
+                engine.getPieceBitboard(RED_CANNON)).any();
+    }
+    return (engine.getPieceBitboard(BLACK_ROOK) | engine.getPieceBitboard(BLACK_KNIGHT) |
+            engine.getPieceBitboard(BLACK_CANNON)).any();
+}
+
+int AIEngine::scoreToTT(int score, int ply) {
+    // 将杀分数在置换表中按距当前节点的步数保存，取出时再换算回距根节点的步数
+    if (score >= MATE_BOUND) return score + ply;
+    if (score <= -MATE_BOUND) return score - ply;
+    return score;
+}
+
+int AIEngine::scoreFromTT(int score, int ply) {
+    if (score >= MATE_BOUND) return score - ply;
+    if (score <= -MATE_BOUND) return score + ply;
+    return score;
 }
 
 int AIEngine::evaluatePosition(const ChessEngine& engine, bool forRed) {
-    int score = 0;
+    // 完整评估即窗口无限大的分层评估
+    return evaluateLazy(engine, forRed, -INFINITE_SCORE, INFINITE_SCORE);
+}
+
+int AIEngine::evaluateLazy(const ChessEngine& engine, bool forRed, int alpha, int beta, EvalCacheStats* stats) {
+    // 第一层：子力与位置分，直接读取
+    int score = evaluateMaterial(engine, forRed);
+    int sideScore = forRed ? score : -score;
+    // 完整评估与子力分之差不超过余量，提前返回时给出该界限
+    if (sideScore - LAZY_EVAL_MARGIN >= beta) return sideScore - LAZY_EVAL_MARGIN;
+    if (sideScore + LAZY_EVAL_MARGIN <= alpha) return sideScore + LAZY_EVAL_MARGIN;
     
-    // 物质评估
-    score += evaluateMaterial(engine, forRed);
+    // 完整评估先查缓存（缓存红方视角的分数，与轮走方无关，双方共用一项）
+    uint64_t key = engine.getBoardKey();
+    if (stats) stats->evalProbes++;
+    if (evalCache.probe(key, score)) {
+        if (stats) stats->evalHits++;
+        return forRed ? score : -score;
+    }
     
-    // 机动性评估
-    score += evaluateMobility(engine, forRed);
+    // 兵形只取决于兵卒位置，命中率远高于完整评估
+    int pawnScore;
+    if (stats) stats->pawnProbes++;
+    if (pawnCache.probe(engine.getPawnKey(), pawnScore)) {
+        if (stats) stats->pawnHits++;
+    } else {
+        pawnScore = evaluatePawnStructure(engine);
+        pawnCache.store(engine.getPawnKey(), pawnScore);
+    }
     
-    // 王安全评估
-    score += evaluateKingSafety(engine, forRed);
+    // 第二层：其余各项共用同一张攻击图，其和截断在余量之内，保证第一层的截断严格成立
+    AttackMap attacks;
+    engine.buildAttackMap(attacks);
+    int positional = evaluateMobility(attacks) + evaluateKingSafety(engine, attacks) +
+                     pawnScore + evaluateControl(engine, attacks);
+    score += std::clamp(positional, -LAZY_EVAL_MARGIN, LAZY_EVAL_MARGIN);
+    evalCache.store(key, score);
     
     return forRed ? score : -score;
 }
 
-int AIEngine::evaluateMaterial(const ChessEngine& engine, bool forRed) {
-    int score = 0;
+// 评估权重
+static const int MOBILITY_WEIGHT = 2;
+static const int MISSING_ADVISOR = 15;      // 缺仕，按对方进攻子力加重
+static const int MISSING_BISHOP = 10;       // 缺相
+static const int PALACE_ATTACK = 6;         // 九宫格点每受一次攻击
+static const int KING_IN_CHECK = 30;
+static const int OPEN_KING_FILE = 20;       // 王前方纵线无本方棋子，每个对方车
+static const int HOLLOW_CANNON = 40;        // 空头炮：炮与王同线且中间无子
+static const int CANNON_SCREEN_THREAT = 12; // 炮与王之间隔两子，移开一子即成将军
+static const int CONNECTED_PAWNS = 15;      // 过河兵左右相连
+static const int HANGING_PAWN = 10;         // 过河兵受攻击且无保护（与其他棋子有关，计入控制项）
+static const int ROOK_OPEN_FILE = 12;       // 车前方纵线无本方棋子
+static const int ROOK_RANK_CONTROL = 2;     // 过河车沿横线每控制一个格点
+static const int TERRITORY_CONTROL = 1;     // 对方半场中本方控制占优的格点
+
+// 单方的王安全扣分
+static int kingDanger(const ChessEngine& engine, const AttackMap& attacks, bool red) {
+    int kingSquare = engine.getKingSquare(red);
+    if (kingSquare < 0) return 0;
     
-    for (int row = 0; row < 10; row++) {
-        for (int col = 0; col < 9; col++) {
-            int piece = engine.getPiece(row, col);
-            if (piece != 0) {
-                score += PIECE_VALUES[piece];
-            }
+    int enemy = red ? 1 : 0;
+    PieceType enemyRook = red ? BLACK_ROOK : RED_ROOK;
+    PieceType enemyCannon = red ? BLACK_CANNON : RED_CANNON;
+    int rooks = engine.getPieceBitboard(enemyRook).count();
+    int threat = 2 * rooks + engine.getPieceBitboard(enemyCannon).count() +
+                 engine.getPieceBitboard(red ? BLACK_KNIGHT : RED_KNIGHT).count();
+    if (threat == 0) return 0;
+    
+    int danger = 0;
+    
+    // 仕相残缺，对方进攻子力越多越危险
+    int advisors = engine.getPieceBitboard(red ? RED_ADVISOR : BLACK_ADVISOR).count();
+    int bishops = engine.getPieceBitboard(red ? RED_BISHOP : BLACK_BISHOP).count();
+    danger += ((2 - advisors) * MISSING_ADVISOR + (2 - bishops) * MISSING_BISHOP) * std::min(threat, 8) / 4;
+    
+    // 九宫受攻击
+    int palaceTop = red ? 7 : 0;
+    for (int row = palaceTop; row < palaceTop + 3; row++) {
+        for (int col = 3; col <= 5; col++) {
+            danger += attacks.count[enemy][ChessEngine::squareOf(row, col)] * PALACE_ATTACK;
         }
     }
+    if (attacks.count[enemy][kingSquare]) {
+        danger += KING_IN_CHECK;
+    }
     
-    return score;
+    // 王前方纵线敞开，对方车可直接沿线进攻
+    int kingRow = ChessEngine::rowOf(kingSquare);
+    int kingCol = ChessEngine::colOf(kingSquare);
+    if (!(engine.getSideBitboard(red) & ChessEngine::aheadMask(kingSquare, red)).any()) {
+        danger += OPEN_KING_FILE * rooks;
+    }
+    
+    // 对方炮与王同线：中间无子为空头炮，中间两子时移开一子即成将军（中间一子已计入将军）
+    Bitboard cannons = engine.getPieceBitboard(enemyCannon);
+    while (cannons.any()) {
+        int sq = cannons.popLowest();
+        if (ChessEngine::rowOf(sq) != kingRow && ChessEngine::colOf(sq) != kingCol) continue;
+        
+        int between = (engine.getOccupied() & ChessEngine::betweenMask(sq, kingSquare)).count();
+        if (between == 0) {
+            danger += HOLLOW_CANNON;
+        } else if (between == 2) {
+            danger += CANNON_SCREEN_THREAT;
+        }
+    }
+    
+    return danger;
 }
 
-int AIEngine::evaluateMobility(const ChessEngine& engine, bool forRed) {
-    std::vector<Move> redMoves = engine.generateLegalMoves(true);
-    std::vector<Move> blackMoves = engine.generateLegalMoves(false);
+// 单方的兵形得分，只看兵卒自身的位置
+static int pawnStructure(const ChessEngine& engine, bool red) {
+    PieceType pawn = red ? RED_PAWN : BLACK_PAWN;
+    int score = 0;
     
-    int mobilityScore = static_cast<int>(redMoves.size()) - static_cast<int>(blackMoves.size());
-    return mobilityScore * 2;
+    Bitboard pawns = engine.getPieceBitboard(pawn);
+    while (pawns.any()) {
+        int sq = pawns.popLowest();
+        int row = ChessEngine::rowOf(sq);
+        int col = ChessEngine::colOf(sq);
+        if (red ? row > 4 : row < 5) continue;
+        
+        // 过河兵左右相连可以互相保护（每对只计一次）
+        if (col < ChessEngine::BOARD_COLS - 1 && engine.getPiece(row, col + 1) == pawn) {
+            score += CONNECTED_PAWNS;
+        }
+    }
+    return score;
 }
 
-int AIEngine::evaluateKingSafety(const ChessEngine& engine, bool forRed) {
+// 单方的控制得分
+static int boardControl(const ChessEngine& engine, const AttackMap& attacks, bool red) {
+    int side = red ? 0 : 1;
     int score = 0;
     
-    // 简单的王安全评估
-    if (engine.isInCheck(true)) score -= 50;
-    if (engine.isInCheck(false)) score += 50;
+    // 车占据敞开的纵线；过河车控制所在横线
+    Bitboard rooks = engine.getPieceBitboard(red ? RED_ROOK : BLACK_ROOK);
+    while (rooks.any()) {
+        int sq = rooks.popLowest();
+        if (!(engine.getSideBitboard(red) & ChessEngine::aheadMask(sq, red)).any()) {
+            score += ROOK_OPEN_FILE;
+        }
+        
+        int row = ChessEngine::rowOf(sq), col = ChessEngine::colOf(sq);
+        if (red ? row > 4 : row < 5) continue;
+        
+        // 向左右数到第一个棋子为止（含该子）
+        int reach = 0;
+        for (int dir = -1; dir <= 1; dir += 2) {
+            for (int c = col + dir; c >= 0 && c < ChessEngine::BOARD_COLS; c += dir) {
+                reach++;
+                if (engine.getPiece(row, c) != NONE) break;
+            }
+        }
+        score += reach * ROOK_RANK_CONTROL;
+    }
     
+    // 过河兵受攻击且无保护
+    Bitboard pawns = engine.getPieceBitboard(red ? RED_PAWN : BLACK_PAWN);
+    while (pawns.any()) {
+        int sq = pawns.popLowest();
+        int row = ChessEngine::rowOf(sq);
+        if (red ? row > 4 : row < 5) continue;
+        
+        if (attacks.count[1 - side][sq] && !attacks.count[side][sq]) {
+            score -= HANGING_PAWN;
+        }
+    }
+    
+    // 对方半场中本方攻击次数占优的格点
+    int first = red ? 0 : 45;
+    for (int sq = first; sq < first + 45; sq++) {
+        if (attacks.count[side][sq] > attacks.count[1 - side][sq]) {
+            score += TERRITORY_CONTROL;
+        }
+    }
     return score;
 }
 
-void AIEngine::orderMoves(std::vector<Move>& moves, const ChessEngine& engine, const Move& hashMove) {
-    std::sort(moves.begin(), moves.end(), [&](const Move& a, const Move& b) {
-        return getMoveOrderScore(a, engine) > getMoveOrderScore(b, engine);
+int AIEngine::evaluateMaterial(const ChessEngine& engine, bool forRed) {
+    // 子力与位置分由棋盘随走子增量维护，这里只需读取
+    return engine.getMaterialScore();
+}
+
+int AIEngine::evaluateMobility(const AttackMap& attacks) {
+    // 只统计车、马、炮的伪合法走法，不检查送将
+    return (attacks.mobility[0] - attacks.mobility[1]) * MOBILITY_WEIGHT;
+}
+
+int AIEngine::evaluateKingSafety(const ChessEngine& engine, const AttackMap& attacks) {
+    // 仕相防守、九宫受攻击、王前纵线敞开与炮的威胁
+    return kingDanger(engine, attacks, false) - kingDanger(engine, attacks, true);
+}
+
+int AIEngine::evaluatePawnStructure(const ChessEngine& engine) {
+    return pawnStructure(engine, true) - pawnStructure(engine, false);
+}
+
+int AIEngine::evaluateControl(const ChessEngine& engine, const AttackMap& attacks) {
+    return boardControl(engine, attacks, true) - boardControl(engine, attacks, false);
+}
+
+void AIEngine::orderMoves(MoveList& moves, const ChessEngine& engine, const Move& hashMove) {
+    // 先算好每个走法的分数再排序，避免在比较函数中重复计算
+    std::vector<std::pair<int, Move>> scored;
+    scored.reserve(moves.size());
+    for (const Move& move : moves) {
+        scored.emplace_back(getMoveOrderScore(move, engine), move);
+    }
+    std::stable_sort(scored.begin(), scored.end(), [](const std::pair<int, Move>& a, const std::pair<int, Move>& b) {
+        return a.first > b.first;
     });
+    for (int i = 0; i < moves.size(); i++) {
+        moves[i] = scored[i].second;
+    }
+    
+    // 置换表中的最佳走法排在最前
+    if (hashMove.isValid()) {
+        moveToIndex(moves, 0, hashMove);
+    }
+}
+
+void AIEngine::moveToIndex(MoveList& moves, int index, const Move& move) {
+    // 将走法移到第index位，其间的走法依次后移，保持原有顺序
+    PackedMove target(move);
+    for (Move* it = moves.begin() + index; it != moves.end(); ++it) {
+        if (PackedMove(*it) == target) {
+            std::rotate(moves.begin() + index, it, it + 1);
+            break;
+        }
+    }
 }
 
 int AIEngine::getMoveOrderScore(const Move& move, const ChessEngine& engine) {
@@ -375,14 +948,7 @@ bool AIEngine::hasOpeningMove(const ChessEngine& engine, Move& move) {
 
 bool AIEngine::hasEndgameMove(const ChessEngine& engine, Move& move) {
     // 简单的残局库实现
-    int pieceCount = 0;
-    for (int row = 0; row < 10; row++) {
-        for (int col = 0; col < 9; col++) {
-            if (engine.getPiece(row, col) != 0) {
-                pieceCount++;
-            }
-        }
-    }
+    int pieceCount = engine.getOccupied().count();
     
     // 如果棋子数量少于8个，认为是残局
     if (pieceCount < 8) {
@@ -394,45 +960,81 @@ bool AIEngine::hasEndgameMove(const ChessEngine& engine, Move& move) {
 }
 
 uint64_t AIEngine::computeHash(const ChessEngine& engine) {
-    uint64_t hash = 0;
+    return engine.getHashKey();
+}
+
+bool AIEngine::isTimeUp() const {
+    // 时钟由checkTime定期检查，这里只读取停止标志
+    return shouldStop.load(std::memory_order_relaxed);
+}
+
+void AIEngine::checkTime(const SearchThread& thread) {
+    if ((thread.nodes.load(std::memory_order_relaxed) & (TIME_CHECK_INTERVAL - 1)) != 0) return;
     
-    for (int row = 0; row < 10; row++) {
-        for (int col = 0; col < 9; col++) {
-            int piece = engine.getPiece(row, col);
-            if (piece != 0) {
-                hash ^= zobristTable[row][col][piece];
-            }
-        }
+    if (timeManager.hardLimitReached()) {
+        shouldStop.store(true, std::memory_order_relaxed);
     }
-    
-    return hash;
 }
 
-void AIEngine::initializeZobrist() {
-    std::random_device rd;
-    std::mt19937_64 gen(rd());
+bool AIEngine::setHashSize(int megabytes) {
+    if (isThinking()) return false;
+    transpositionTable.resize(megabytes);
+    return true;
+}
+
+bool AIEngine::clearHash() {
+    if (isThinking()) return false;
+    transpositionTable.clear();
+    evalCache.clear();
+    pawnCache.clear();
+    return true;
+}
+
+bool AIEngine::loadPieceSquareTables(const std::string& filename) {
+    if (isThinking()) return false;
+    if (!PieceSquareTable::loadFromFile(filename)) return false;
     
-    for (int row = 0; row < 10; row++) {
-        for (int col = 0; col < 9; col++) {
-            for (int piece = 0; piece < 15; piece++) {
-                zobristTable[row][col][piece] = gen();
-            }
-        }
+    // 缓存的评分按旧表计算，需要作废
+    evalCache.clear();
+    return true;
+}
+
+void AIEngine::setTimeControl(double remaining, double increment, int movesToGo) {
+    settings.timeControl.remaining = remaining;
+    settings.timeControl.increment = increment;
+    settings.timeControl.movesToGo = movesToGo;
+}
+
+int64_t AIEngine::totalNodes() const {
+    int64_t total = 0;
+    for (const auto& thread : searchThreads) {
+        total += thread->nodes.load(std::memory_order_relaxed);
     }
-    
-    zobristInitialized = true;
+    return total;
 }
 
-bool AIEngine::isTimeUp() const {
-    auto currentTime = std::chrono::steady_clock::now();
-    double elapsed = std::chrono::duration<double>(currentTime - searchStartTime).count();
-    return elapsed >= timeLimit || shouldStop;
+void AIEngine::reportProgress(const SearchThread& thread) {
+    if (!progressCallback) return;
+    
+    SearchProgress progress;
+    progress.depth = thread.completedDepth;
+    progress.score = thread.bestScore;
+    progress.pv = thread.pv;
+    progress.lines = thread.lines;
+    progress.nodes = totalNodes();
+    progress.timeUsed = timeManager.elapsed();
+    progress.nps = progress.timeUsed > 0.0 ? static_cast<int64_t>(progress.nodes / progress.timeUsed) : 0;
+    progressCallback(progress);
 }
 
 bool AIEngine::isCapture(const Move& move, const ChessEngine& engine) {
     return engine.getPiece(move.toRow, move.toCol) != 0;
 }
 
+bool AIEngine::isCheck(const Move& move, ChessEngine& engine) {
+    return engine.givesCheck(move);
+}
+
 std::string AIEngine::positionToString(const ChessEngine& engine) {
     return "position_string"; // 简化实现
 }
@@ -445,35 +1047,62 @@ void AIEngine::debugPrint(const std::string& message) const {
 
 void AIEngine::clearStatistics() {
     nodesSearched = 0;
+    cacheStats = EvalCacheStats();
     lastThinkingTime = 0.0;
 }
 
 EvaluationResult AIEngine::analyzePosition(const ChessEngine& engine, bool forRed) {
-    EvaluationResult result;
-    result.score = evaluatePosition(engine, forRed);
-    result.bestMove = getBestMove(engine, forRed);
-    result.depth = maxDepth;
-    result.nodesSearched = this->nodesSearched;
-    result.timeUsed = lastThinkingTime;
+    // 一次搜索同时得到评分、主要变例和多主变的各条变例
+    Move bestMove = getBestMove(engine, forRed);
+    EvaluationResult result = currentResult;
+    
+    // 开局库、残局库或只有一个合法走法时没有搜索，评分用静态评估
+    if (result.depth == 0) {
+        result.bestMove = bestMove;
+        result.score = evaluatePosition(engine, forRed);
+    }
     return result;
 }
 
 std::string AIEngine::getSearchInfo() const {
+    // 命中率以百分比表示，没有查询时记为0
+    auto hitRate = [](int64_t hits, int64_t probes) {
+        return std::to_string(probes > 0 ? hits * 100 / probes : 0) + "%";
+    };
+    
     return "Nodes: " + std::to_string(nodesSearched) + 
-           ", Time: " + std::to_string(lastThinkingTime) + "s";
+           ", Time: " + std::to_string(lastThinkingTime) + "s" +
+           ", Hashfull: " + std::to_string(transpositionTable.hashfull()) + "‰" +
+           ", Eval cache: " + hitRate(cacheStats.evalHits, cacheStats.evalProbes) +
+           ", Pawn cache: " + hitRate(cacheStats.pawnHits, cacheStats.pawnProbes);
 }
 
 void AIEngine::stopThinking() {
     shouldStop = true;
+    if (thinkingThread.joinable()) {
+        thinkingThread.join();
+    }
     thinkingState = AI_IDLE;
 }
 
 void AIEngine::startThinking(const ChessEngine& engine, bool forRed) {
-    // 简单实现，直接调用getBestMove
+    // 结束上一次尚未完成的思考
+    stopThinking();
+    
+    shouldStop = false;
+    applySettings();
     thinkingState = AI_THINKING;
-    Move result = getBestMove(engine, forRed);
-    thinkingResult = result;
-    thinkingState = AI_FINISHED;
+    
+    // 工作线程使用棋盘副本，调用者可继续操作原棋盘
+    thinkingThread = std::thread([this, engine, forRed]() {
+        Move result = searchBestMove(engine, forRed);
+        thinkingResult = result;
+        thinkingState = AI_FINISHED;
+        
+        if (finishedCallback) {
+            finishedCallback(result);
+        }
+    });
 }
 
 Move AIEngine::getThinkingResult() {
@@ -2,10 +2,20 @@
 #define AIENGINE_H
 
 #include "ChessEngine.h"
+#include "TranspositionTable.h"
+#include "MovePicker.h"
+#include "TimeManager.h"
+#include "PieceSquareTable.h"
+#include "EvaluationCache.h"
 #include <vector>
+#include <algorithm>
 #include <unordered_map>
 #include <chrono>
 #include <random>
+#include <atomic>
+#include <thread>
+#include <functional>
+#include <memory>
 
 // AI难度级别
 enum AIDifficulty {
@@ -22,26 +32,40 @@ enum AIThinkingState {
     AI_FINISHED
 };
 
+// 根节点的一条变例（多主变分析时每个候选走法一条）
+struct SearchLine {
+    Move move;              // 根节点走法
+    int score;              // 评分（走棋方视角）
+    std::vector<Move> pv;   // 主要变例，以move开头
+    
+    SearchLine() : score(0) {}
+};
+
 // 评估结果结构
 struct EvaluationResult {
     int score;           // 局面评分
     Move bestMove;       // 最佳走法
     int depth;           // 搜索深度
-    int nodesSearched;   // 搜索节点数
+    int64_t nodesSearched;   // 搜索节点数（所有线程之和）
     double timeUsed;     // 用时（秒）
+    std::vector<int64_t> threadNodes;  // 各搜索线程的节点数
+    std::vector<Move> pv;          // 主要变例
+    std::vector<SearchLine> lines; // 多主变模式下按评分从高到低排列的各条变例
     
     EvaluationResult() : score(0), depth(0), nodesSearched(0), timeUsed(0.0) {}
 };
 
-// 置换表项
-struct TranspositionEntry {
-    uint64_t hash;       // 局面哈希值
-    int score;           // 评分
-    int depth;           // 搜索深度
-    Move bestMove;       // 最佳走法
-    enum NodeType { EXACT, LOWER_BOUND, UPPER_BOUND } type;
+// 搜索进度（每完成一次迭代报告一次）
+struct SearchProgress {
+    int depth;              // 已完成的深度
+    int score;              // 评分（走棋方视角）
+    std::vector<Move> pv;   // 主要变例
+    std::vector<SearchLine> lines;  // 多主变模式下的各条变例
+    int64_t nodes;          // 搜索节点数（所有线程之和）
+    int64_t nps;            // 每秒节点数
+    double timeUsed;        // 已用时间（秒）
     
-    TranspositionEntry() : hash(0), score(0), depth(0), type(EXACT) {}
+    SearchProgress() : depth(0), score(0), nodes(0), nps(0), timeUsed(0.0) {}
 };
 
 // AI引擎类
@@ -54,20 +78,58 @@ public:
     void setDifficulty(AIDifficulty difficulty);
     AIDifficulty getDifficulty() const { return difficulty; }
     
-    void setMaxDepth(int depth) { maxDepth = depth; }
-    int getMaxDepth() const { return maxDepth; }
+    void setMaxDepth(int depth) { settings.maxDepth = depth; }
+    int getMaxDepth() const { return settings.maxDepth; }
+    
+    void setTimeLimit(double seconds) { settings.timeLimit = seconds; }
+    double getTimeLimit() const { return settings.timeLimit; }
+    
+    // 对局计时：设置后按本方剩余时间分配每步用时，固定时限仍作为每步上限
+    void setTimeControl(double remaining, double increment = 0.0, int movesToGo = 0);
+    void clearTimeControl() { settings.timeControl = TimeControl(); }
+    
+    void setRandomness(double factor) { settings.randomnessFactor = factor; }
+    double getRandomness() const { return settings.randomnessFactor; }
+    
+    // 剪枝与衰减参数（余量为每层的评分，设为0表示关闭对应剪枝）
+    void setLateMoveReductions(bool enabled) { settings.lateMoveReductions = enabled; }
+    bool getLateMoveReductions() const { return settings.lateMoveReductions; }
+    void setReductionFactors(double base, double divisor);
+    
+    void setFutilityMargin(int margin) { settings.futilityMargin = margin; }
+    int getFutilityMargin() const { return settings.futilityMargin; }
+    
+    void setReverseFutilityMargin(int margin) { settings.reverseFutilityMargin = margin; }
+    int getReverseFutilityMargin() const { return settings.reverseFutilityMargin; }
+    
+    void setRazorMargin(int margin) { settings.razorMargin = margin; }
+    int getRazorMargin() const { return settings.razorMargin; }
     
-    void setTimeLimit(double seconds) { timeLimit = seconds; }
-    double getTimeLimit() const { return timeLimit; }
+    // 置换表大小（MB）。重新分配或清空时搜索线程仍在读写，思考期间拒绝执行并返回false
+    bool setHashSize(int megabytes);
+    int getHashSize() const { return static_cast<int>(transpositionTable.getSizeMB()); }
+    bool clearHash();
+    int getHashFull() const { return transpositionTable.hashfull(); }
     
-    void setRandomness(double factor) { randomnessFactor = factor; }
-    double getRandomness() const { return randomnessFactor; }
+    // 搜索线程数（Lazy SMP，所有线程共享置换表）
+    void setThreads(int count) { settings.threadCount = std::max(1, std::min(count, MAX_THREADS)); }
+    int getThreads() const { return settings.threadCount; }
+    
+    // 多主变：一次搜索给出评分最高的若干个根节点走法及其变例
+    void setMultiPV(int count) { settings.multiPV = std::max(1, count); }
+    int getMultiPV() const { return settings.multiPV; }
     
     // AI思考
     Move getBestMove(const ChessEngine& engine, bool forRed = false);
     EvaluationResult analyzePosition(const ChessEngine& engine, bool forRed = false);
     
-    // 异步思考（用于UI响应）
+    // 异步思考（用于UI响应）：在工作线程中搜索，stopThinking可随时中断
+    // 回调在搜索线程中调用，界面需自行转回主线程，且不能在回调中调用startThinking/stopThinking
+    using ProgressCallback = std::function<void(const SearchProgress&)>;
+    using FinishedCallback = std::function<void(const Move&)>;
+    void setProgressCallback(ProgressCallback callback) { progressCallback = std::move(callback); }
+    void setFinishedCallback(FinishedCallback callback) { finishedCallback = std::move(callback); }
+    
     void startThinking(const ChessEngine& engine, bool forRed = false);
     bool isThinking() const { return thinkingState == AI_THINKING; }
     bool hasResult() const { return thinkingState == AI_FINISHED; }
@@ -81,11 +143,14 @@ public:
     bool hasOpeningMove(const ChessEngine& engine, Move& move);
     void loadOpeningBook(const std::string& filename);
     
+    // 子力与位置价值表（用于调参，全局生效）。思考期间拒绝加载并返回false
+    bool loadPieceSquareTables(const std::string& filename);
+    
     // 残局库
     bool hasEndgameMove(const ChessEngine& engine, Move& move);
     
     // 统计信息
-    int getNodesSearched() const { return nodesSearched; }
+    int64_t getNodesSearched() const { return nodesSearched; }
     double getLastThinkingTime() const { return lastThinkingTime; }
     void clearStatistics();
     
@@ -95,26 +160,140 @@ public:
     
 private:
     // AI参数
+    struct SearchSettings {
+        int maxDepth;
+        double timeLimit;
+        double randomnessFactor;
+        int threadCount;
+        int multiPV;
+        TimeControl timeControl;
+        
+        // 剪枝参数
+        bool lateMoveReductions;
+        double reductionBase;
+        double reductionDivisor;
+        int futilityMargin;
+        int reverseFutilityMargin;
+        int razorMargin;
+        
+        SearchSettings()
+            : maxDepth(4), timeLimit(5.0), randomnessFactor(0.1), threadCount(1), multiPV(1),
+              lateMoveReductions(true), reductionBase(0.75), reductionDivisor(2.25),
+              futilityMargin(150), reverseFutilityMargin(120), razorMargin(300) {}
+    };
+    
+    // 设置函数只修改settings，开始搜索时复制到params，搜索线程只读params，
+    // 思考期间修改这些设置不会与工作线程冲突，从下一次搜索起生效。
+    // 置换表、评估缓存和位置价值表由搜索线程直接使用，思考期间不能修改（见setHashSize等）
     AIDifficulty difficulty;
-    int maxDepth;
-    double timeLimit;
-    double randomnessFactor;
+    SearchSettings settings;
+    SearchSettings params;
+    static constexpr int MAX_THREADS = 256;
+    void applySettings();
+    
+    // 后期走法衰减表：按剩余深度和走法序号预先计算
+    static constexpr int REDUCTION_TABLE_SIZE = 64;
+    static constexpr int LMR_MIN_DEPTH = 3;
+    static constexpr int PRUNING_MAX_DEPTH = 3;     // 无益裁剪与剃刀只在叶子附近使用
+    int reductionTable[REDUCTION_TABLE_SIZE][REDUCTION_TABLE_SIZE];
+    void initReductionTable();
+    
+    // 评估缓存的查询与命中次数
+    struct EvalCacheStats {
+        int64_t evalProbes = 0;
+        int64_t evalHits = 0;
+        int64_t pawnProbes = 0;
+        int64_t pawnHits = 0;
+        
+        void add(const EvalCacheStats& other) {
+            evalProbes += other.evalProbes;
+            evalHits += other.evalHits;
+            pawnProbes += other.pawnProbes;
+            pawnHits += other.pawnHits;
+        }
+    };
+    
+    // 单个搜索线程的状态，每个线程拥有独立的棋盘副本
+    struct SearchThread {
+        ChessEngine engine;
+        int id;
+        std::atomic<int64_t> nodes;   // 仅本线程写入，其他线程可随时读取进度
+        int completedDepth;   // 已完整搜索的深度
+        int rootDepth;        // 当前迭代的深度，用于限制将军延伸
+        int bestScore;
+        Move bestMove;
+        std::vector<Move> pv;                 // 最近一次完成迭代的主要变例
+        std::vector<SearchLine> lines;        // 最近一次完成迭代的各条变例
+        // 最近一次完成迭代与当前迭代中已证明的根节点走法评分下界（降低棋力时从中挑选）
+        std::vector<std::pair<int, Move>> rootScores;
+        std::vector<std::pair<int, Move>> iterationScores;
+        SearchHeuristics heuristics;          // 杀手、历史与应着表
+        EvalCacheStats cacheStats;            // 每线程单独计数，避免共享计数器的争用
+        PackedMove moveStack[SearchHeuristics::MAX_PLY];  // 各层刚走过的走法，用于查应着
+        
+        // 三角主变表：第ply行保存从该层开始的主要变例，长度为pvLength[ply] - ply
+        PackedMove pvTable[SearchHeuristics::MAX_PLY][SearchHeuristics::MAX_PLY];
+        int pvLength[SearchHeuristics::MAX_PLY];
+        
+        SearchThread() : id(0), nodes(0), completedDepth(0), rootDepth(0), bestScore(0) {}
+        
+        // 单写者计数，无需原子读改写指令
+        void countNode() { nodes.store(nodes.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed); }
+        
+        // 走法成为该层的新最佳走法时，接上下一层的变例
+        void updatePV(int ply, PackedMove move) {
+            pvTable[ply][ply] = move;
+            for (int i = ply + 1; i < pvLength[ply + 1]; i++) {
+                pvTable[ply][i] = pvTable[ply + 1][i];
+            }
+            pvLength[ply] = pvLength[ply + 1];
+        }
+        
+        // 期望窗口重搜或后续变例再次搜到同一走法时，以最后一次的结果为准
+        void recordRootScore(const Move& move, int score) {
+            for (auto& entry : iterationScores) {
+                if (PackedMove(entry.second) == PackedMove(move)) {
+                    entry.first = score;
+                    return;
+                }
+            }
+            iterationScores.emplace_back(score, move);
+        }
+        
+        std::vector<Move> rootPV() const {
+            std::vector<Move> line;
+            for (int i = 0; i < pvLength[0]; i++) {
+                line.push_back(pvTable[0][i].toMove());
+            }
+            return line;
+        }
+    };
     
     // 搜索状态
-    AIThinkingState thinkingState;
+    std::atomic<AIThinkingState> thinkingState;
+    std::thread thinkingThread;
+    ProgressCallback progressCallback;
+    FinishedCallback finishedCallback;
+    std::vector<std::unique_ptr<SearchThread>> searchThreads;
     EvaluationResult currentResult;
     Move thinkingResult;
-    std::chrono::steady_clock::time_point searchStartTime;
-    bool shouldStop;
+    TimeManager timeManager;
+    std::atomic<bool> shouldStop;
     
     // 统计信息
-    int nodesSearched;
+    int64_t nodesSearched;
+    EvalCacheStats cacheStats;   // 最近一次搜索各线程之和
     double lastThinkingTime;
     bool debugMode;
     
     // 置换表
-    std::unordered_map<uint64_t, TranspositionEntry> transpositionTable;
-    static const size_t MAX_TT_SIZE = 1000000;  // 最大置换表大小
+    TranspositionTable transpositionTable;
+    
+    // 评估缓存：完整评估按局面哈希缓存，兵形按只含兵卒的哈希缓存，各线程共享
+    static constexpr size_t EVAL_CACHE_ENTRIES = 1 << 16;
+    static constexpr size_t PAWN_CACHE_ENTRIES = 1 << 12;
+    EvaluationCache evalCache;
+    EvaluationCache pawnCache;
     
     // 开局库
     std::unordered_map<std::string, std::vector<Move>> openingBook;
@@ -123,32 +302,63 @@ private:
     std::mt19937 randomGenerator;
     
     // 核心搜索算法
-    int alphaBeta(ChessEngine& engine, int depth, int alpha, int beta, bool maximizing);
-    int quiescenceSearch(ChessEngine& engine, int alpha, int beta, bool maximizing, int qDepth = 0);
+    Move searchBestMove(const ChessEngine& engine, bool forRed);
+    void iterativeDeepening(SearchThread& thread, const MoveList& rootMoves, bool forRed);
+    bool searchRootLine(SearchThread& thread, const MoveList& rootMoves, int firstIndex, int depth,
+                        int previousScore, SearchLine& line);
+    int searchRoot(SearchThread& thread, const MoveList& rootMoves, int firstIndex, int depth, int alpha, int beta,
+                   Move& bestMove);
+    int alphaBeta(SearchThread& thread, int depth, int alpha, int beta, int ply, bool allowNull = true);
+    int quiescenceSearch(SearchThread& thread, int alpha, int beta, int ply, int qDepth = 0);
+    
+    // 搜索评分均以走棋方为准（负极大值），将杀分数随步数递减
+    static constexpr int MATE_SCORE = 10000;
+    static constexpr int MAX_PLY = SearchHeuristics::MAX_PLY;
+    static constexpr int MATE_BOUND = MATE_SCORE - MAX_PLY;
+    static constexpr int INFINITE_SCORE = 30000;
+    static constexpr int ASPIRATION_WINDOW = 50;
+    static constexpr int MAX_QUIESCENCE_CHECKS = 4;  // 静态搜索中尝试的不吃子将军走法数
+    
+    // 空着裁剪
+    static constexpr int NULL_MOVE_MIN_DEPTH = 3;
+    static constexpr int NULL_MOVE_VERIFY_DEPTH = 6;   // 达到该深度时对空着截断做验证搜索
+    bool canTryNullMove(const ChessEngine& engine, bool red) const;
+    static int scoreToTT(int score, int ply);
+    static int scoreFromTT(int score, int ply);
+    static int repetitionScore(RepetitionType type, int ply);
     
     // 走法排序
-    void orderMoves(std::vector<Move>& moves, const ChessEngine& engine, const Move& hashMove);
+    void orderMoves(MoveList& moves, const ChessEngine& engine, const Move& hashMove);
+    static void moveToIndex(MoveList& moves, int index, const Move& move);
     int getMoveOrderScore(const Move& move, const ChessEngine& engine);
     
-    // 评估函数组件
+    // 分层评估：先算增量维护的子力与位置分，远在窗口之外时不再计算其余各项，
+    // 而返回按余量放宽后仍落在窗口外的界限。
+    // 完整评估结果写入评估缓存，stats不为空时记录缓存命中情况
+    static constexpr int LAZY_EVAL_MARGIN = 300;    // 子力以外各项之和的上限，超出部分截去
+    int evaluateLazy(const ChessEngine& engine, bool forRed, int alpha, int beta, EvalCacheStats* stats = nullptr);
+    
+    // 评估函数组件（红方视角，除子力外共用同一张攻击图）
     int evaluateMaterial(const ChessEngine& engine, bool forRed);
-    int evaluateMobility(const ChessEngine& engine, bool forRed);
-    int evaluateKingSafety(const ChessEngine& engine, bool forRed);
-    int evaluatePawnStructure(const ChessEngine& engine, bool forRed);
-    int evaluateControl(const ChessEngine& engine, bool forRed);
+    int evaluateMobility(const AttackMap& attacks);
+    int evaluateKingSafety(const ChessEngine& engine, const AttackMap& attacks);
+    int evaluatePawnStructure(const ChessEngine& engine);   // 只取决于兵卒位置，可按兵形哈希缓存
+    int evaluateControl(const ChessEngine& engine, const AttackMap& attacks);
     
     // 棋子价值表
     static const int PIECE_VALUES[15];
-    static const int POSITION_VALUES[15][10][9];
     
-    // 哈希函数
+    // 哈希函数（由ChessEngine增量维护）
     uint64_t computeHash(const ChessEngine& engine);
-    static uint64_t zobristTable[10][9][15];
-    static bool zobristInitialized;
-    static void initializeZobrist();
     
-    // 时间管理
+    // 时间管理：搜索中每隔TIME_CHECK_INTERVAL个节点读取一次时钟
+    static constexpr int TIME_CHECK_INTERVAL = 1024;
     bool isTimeUp() const;
+    void checkTime(const SearchThread& thread);
+    
+    // 进度报告
+    int64_t totalNodes() const;
+    void reportProgress(const SearchThread& thread);
     
     // 辅助函数
     bool isCapture(const Move& move, const ChessEngine& engine);
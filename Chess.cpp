@@ -21,6 +21,7 @@
 #include <QSvgRenderer>
 #include <QDebug>
 #include <vector>
+#include <algorithm>
 
 // PieceStyleManager 实现
 PieceStyleManager& PieceStyleManager::getInstance() {
@@ -142,7 +143,7 @@ QColor PieceStyleManager::getPieceBackgroundColor(PieceType piece) const {
 
 // ChessBoard 类实现
 ChessBoard::ChessBoard(QWidget *parent)
-    : QWidget(parent), selectedPos(-1, -1), pieceSelected(false), mousePos(0, 0), styleManager(PieceStyleManager::getInstance())
+    : QWidget(parent), selectedPos(-1, -1), pieceSelected(false), inputEnabled(true), mousePos(0, 0), styleManager(PieceStyleManager::getInstance())
 {
     setFixedSize(BOARD_WIDTH * CELL_SIZE + 2 * BOARD_MARGIN, 
                  BOARD_HEIGHT * CELL_SIZE + 2 * BOARD_MARGIN);
@@ -239,7 +240,8 @@ void ChessBoard::goToMove(int index)
 bool ChessBoard::isGameOver() const
 {
     bool redTurn = engine.isRedTurn();
-    return engine.isCheckmate(redTurn) || engine.isStalemate(redTurn);
+    return engine.isCheckmate(redTurn) || engine.isStalemate(redTurn) ||
+           engine.getRepetitionCount() >= 2;
 }
 
 bool ChessBoard::isRedTurn() const
@@ -288,6 +290,25 @@ void ChessBoard::updateGameStatus()
     
     if (engine.isCheckmate(redTurn)) {
         gameStatus = redTurn ? "红方被将死，黑方获胜" : "黑方被将死，红方获胜";
+    } else if (engine.getRepetitionCount() >= 2) {
+        // 同一局面第三次出现时按长将、长捉规则裁决
+        switch (engine.getRepetitionType()) {
+            case REPETITION_PERPETUAL_CHECK:
+                gameStatus = redTurn ? "红方长将，黑方获胜" : "黑方长将，红方获胜";
+                break;
+            case REPETITION_OPPONENT_CHECK:
+                gameStatus = redTurn ? "黑方长将，红方获胜" : "红方长将，黑方获胜";
+                break;
+            case REPETITION_PERPETUAL_CHASE:
+                gameStatus = redTurn ? "红方长捉，黑方获胜" : "黑方长捉，红方获胜";
+                break;
+            case REPETITION_OPPONENT_CHASE:
+                gameStatus = redTurn ? "黑方长捉，红方获胜" : "红方长捉，黑方获胜";
+                break;
+            default:
+                gameStatus = "重复局面，和棋";
+                break;
+        }
     } else if (engine.isStalemate(redTurn)) {
         gameStatus = "和棋";
     } else if (engine.isInCheck(redTurn)) {
@@ -509,6 +530,8 @@ QColor ChessBoard::getPieceColor(PieceType piece)
 
 void ChessBoard::mousePressEvent(QMouseEvent *event)
 {
+    if (!inputEnabled) return;
+    
     if (event->button() == Qt::LeftButton) {
         QPoint boardPos = pixelToBoard(event->pos());
         
@@ -566,6 +589,7 @@ void ChessBoard::mouseMoveEvent(QMouseEvent *event)
 // Chess 主窗口类实现
 Chess::Chess(QWidget *parent)
     : QMainWindow(parent), chessBoard(nullptr), styleComboBox(nullptr),
+      timeIncrement(0.0), clockTimer(nullptr),
       aiEngine(nullptr), aiEnabled(false), aiThinking(false), aiTimer(nullptr),
       connectionDialog(nullptr)
 {
@@ -761,6 +785,12 @@ void Chess::initializeNewControls()
     addDockWidget(Qt::RightDockWidgetArea, timeControlDockWidget);
     tabifyDockWidget(gameControlDockWidget, timeControlDockWidget);
     
+    // 计时显示每秒刷新一次
+    clockTimer = new QTimer(this);
+    connect(clockTimer, &QTimer::timeout, this, [this]() { updateClockLabels(); });
+    clockTimer->start(1000);
+    resetClocks();
+    
     // 创建引擎控制dock窗口
     engineControlDockWidget = new QDockWidget("引擎控制", this);
     engineControlDockWidget->setAllowedAreas(Qt::LeftDockWidgetArea | Qt::RightDockWidgetArea);
@@ -1127,9 +1157,11 @@ void Chess::setupMainLayout()
 
 void Chess::onNewGame()
 {
+    cancelAIThinking();
     chessBoard->initializeBoard();
     moveHistoryTable->clearContents();
     moveHistoryTable->setRowCount(0);
+    resetClocks();
     statusBar()->showMessage("新游戏开始", 3000);
     updateGameInfo();
 }
@@ -1155,9 +1187,49 @@ void Chess::onMoveExecuted(const Move& move)
     // 滚动到最新走法
     moveHistoryTable->scrollToBottom();
     
+    // 本步用时记到刚走棋的一方，并开始对方计时
+    SideClock& clock = chessBoard->getEngine().isRedTurn() ? blackClock : redClock;
+    double elapsed = turnTimer.elapsed() / 1000.0;
+    clock.remaining += timeIncrement - elapsed;
+    clock.used += elapsed;
+    clock.lastMove = elapsed;
+    turnTimer.restart();
+    updateClockLabels();
+    
     updateGameInfo();
 }
 
+void Chess::resetClocks()
+{
+    redClock = { DEFAULT_GAME_TIME, 0.0, 0.0 };
+    blackClock = { DEFAULT_GAME_TIME, 0.0, 0.0 };
+    turnTimer.start();
+    updateClockLabels();
+}
+
+void Chess::updateClockLabels()
+{
+    if (!chessBoard || !redRemainingLabel || !blackRemainingLabel) return;
+    
+    auto format = [](double seconds) {
+        int total = std::max(0, static_cast<int>(seconds));
+        return QString("%1:%2").arg(total / 60, 3, 10, QChar('0')).arg(total % 60, 2, 10, QChar('0'));
+    };
+    
+    // 走棋方的显示包含本步已经用掉的时间
+    bool redTurn = chessBoard->getEngine().isRedTurn();
+    double running = turnTimer.elapsed() / 1000.0;
+    double redRunning = redTurn ? running : 0.0;
+    double blackRunning = redTurn ? 0.0 : running;
+    
+    redUsedTimeLabel->setText("已用时:　　" + format(redClock.used + redRunning));
+    redLastMoveLabel->setText("上步时:　　" + format(redClock.lastMove));
+    redRemainingLabel->setText("剩余时:　　" + format(redClock.remaining - redRunning));
+    blackUsedTimeLabel->setText("已用时:　　" + format(blackClock.used + blackRunning));
+    blackLastMoveLabel->setText("上步时:　　" + format(blackClock.lastMove));
+    blackRemainingLabel->setText("剩余时:　　" + format(blackClock.remaining - blackRunning));
+}
+
 void Chess::onGameStatusChanged(const QString& status)
 {
     statusBar()->showMessage(status);
@@ -1170,11 +1242,13 @@ void Chess::onBoardChanged()
 
 void Chess::onMoveFirst()
 {
+    cancelAIThinking();
     chessBoard->goToMove(-1);
 }
 
 void Chess::onMovePrevious()
 {
+    cancelAIThinking();
     const MoveHistory& history = chessBoard->getMoveHistory();
     if (!history.isAtFirst()) {
         chessBoard->goToMove(history.getCurrentIndex() - 1);
@@ -1183,6 +1257,7 @@ void Chess::onMovePrevious()
 
 void Chess::onMoveNext()
 {
+    cancelAIThinking();
     const MoveHistory& history = chessBoard->getMoveHistory();
     if (!history.isAtLast()) {
         chessBoard->goToMove(history.getCurrentIndex() + 1);
@@ -1191,6 +1266,7 @@ void Chess::onMoveNext()
 
 void Chess::onMoveLast()
 {
+    cancelAIThinking();
     const MoveHistory& history = chessBoard->getMoveHistory();
     chessBoard->goToMove(history.getMoveCount() - 1);
 }
@@ -1215,6 +1291,7 @@ void Chess::onLoadGame()
     QString fileName = QFileDialog::getOpenFileName(this, 
         "加载棋谱", "", "棋谱文件 (*.pgn *.txt);;所有文件 (*)");
     if (!fileName.isEmpty()) {
+        cancelAIThinking();
         statusLabel->setText("棋谱加载功能待实现");
     }
 }
@@ -1254,6 +1331,14 @@ void Chess::setupAIEngine()
     aiEngine->setDifficulty(AI_MEDIUM);
     aiEngine->setDebugMode(true);
     
+    // AI在工作线程中思考，回调通过队列连接转回界面线程处理
+    aiEngine->setProgressCallback([this](const SearchProgress& progress) {
+        QMetaObject::invokeMethod(this, [this, progress]() { showAIProgress(progress); }, Qt::QueuedConnection);
+    });
+    aiEngine->setFinishedCallback([this](const Move&) {
+        QMetaObject::invokeMethod(this, [this]() { onAIThinkingFinished(); }, Qt::QueuedConnection);
+    });
+    
     // 创建AI定时器
     aiTimer = new QTimer(this);
     aiTimer->setSingleShot(true);
@@ -1333,6 +1418,18 @@ void Chess::updateAIControls()
         stopAIButton->setEnabled(aiThinking);
     }
     
+    // 思考期间棋盘不接受落子，AI设置也不能修改
+    chessBoard->setInputEnabled(!aiThinking);
+    if (aiDifficultyCombo) {
+        aiDifficultyCombo->setEnabled(!aiThinking);
+    }
+    if (engineDepthSpinBox) {
+        engineDepthSpinBox->setEnabled(!aiThinking);
+    }
+    if (engineTimeSpinBox) {
+        engineTimeSpinBox->setEnabled(!aiThinking);
+    }
+    
     if (aiStatusLabel) {
         if (aiThinking) {
             aiStatusLabel->setText("AI思考中...");
@@ -1361,12 +1458,24 @@ void Chess::makeAIMove()
     aiThinking = true;
     updateAIControls();
     
-    // 获取当前棋盘状态
+    // 按AI一方的剩余时间分配本步用时（剩余时间须为正，否则视为不计时）
     ChessEngine& engine = chessBoard->getEngine();
-    bool isRedTurn = engine.isRedTurn();
+    const SideClock& clock = engine.isRedTurn() ? redClock : blackClock;
+    double remaining = clock.remaining - turnTimer.elapsed() / 1000.0;
+    aiEngine->setTimeControl(std::max(remaining, 0.01), timeIncrement);
+    
+    // 在工作线程中异步思考，完成后由onAIThinkingFinished落子
+    aiEngine->startThinking(engine, engine.isRedTurn());
+}
+
+void Chess::onAIThinkingFinished()
+{
+    // 思考已被停止时丢弃结果
+    if (!aiEngine || !chessBoard || !aiThinking || !aiEngine->hasResult()) return;
     
-    // AI思考
-    Move aiMove = aiEngine->getBestMove(engine, isRedTurn);
+    ChessEngine& engine = chessBoard->getEngine();
+    bool isRedTurn = engine.isRedTurn();
+    Move aiMove = aiEngine->getThinkingResult();
     
     aiThinking = false;
     updateAIControls();
@@ -1395,6 +1504,25 @@ void Chess::makeAIMove()
     }
 }
 
+void Chess::showAIProgress(const SearchProgress& progress)
+{
+    if (!aiThinking || !aiStatusLabel) return;
+    
+    QStringList pvMoves;
+    for (const Move& move : progress.pv) {
+        pvMoves << QString::fromStdString(move.toString());
+    }
+    
+    aiStatusLabel->setText(QString("AI思考中... 深度: %1, 评分: %2")
+        .arg(progress.depth)
+        .arg(progress.score));
+    aiStatusLabel->setToolTip(QString("主要变例: %1\n节点数: %2, 速度: %3 nps, 用时: %4秒")
+        .arg(pvMoves.join(' '))
+        .arg(progress.nodes)
+        .arg(progress.nps)
+        .arg(progress.timeUsed, 0, 'f', 2));
+}
+
 void Chess::onAIEnabled(bool enabled)
 {
     aiEnabled = enabled;
@@ -1450,6 +1578,13 @@ void Chess::onAIMove()
 
 void Chess::onStopAI()
 {
+    cancelAIThinking();
+    statusBar()->showMessage("AI思考已停止", 2000);
+}
+
+void Chess::cancelAIThinking()
+{
+    // 停止思考并丢弃结果，避免把为旧局面算出的走法下到新局面上
     if (aiEngine) {
         aiEngine->stopThinking();
     }
@@ -1460,8 +1595,6 @@ void Chess::onStopAI()
     
     aiThinking = false;
     updateAIControls();
-    
-    statusBar()->showMessage("AI思考已停止", 2000);
 }
 
 /**
@@ -1496,6 +1629,7 @@ void Chess::onImportPGN()
         "导入PGN文件", "", "PGN文件 (*.pgn);;所有文件 (*)");
     
     if (!fileName.isEmpty()) {
+        cancelAIThinking();
         // TODO: 实现PGN文件导入功能
         statusBar()->showMessage("PGN文件导入功能待实现: " + fileName, 3000);
     }
@@ -1532,6 +1666,7 @@ void Chess::onCopyPosition()
  */
 void Chess::onPastePosition()
 {
+    cancelAIThinking();
     // TODO: 实现局面粘贴功能
     statusBar()->showMessage("粘贴局面功能待实现", 2000);
 }
@@ -1542,6 +1677,7 @@ void Chess::onPastePosition()
  */
 void Chess::onSetupPosition()
 {
+    cancelAIThinking();
     // TODO: 实现局面设置功能
     statusBar()->showMessage("设置局面功能待实现", 2000);
 }
@@ -20,6 +20,7 @@
 #include <QPainter>
 #include <QTimer>
 #include <QDateTime>
+#include <QElapsedTimer>
 #include <QMouseEvent>
 #include <QPaintEvent>
 #include <QPoint>
@@ -97,6 +98,9 @@ public:
     // 引擎访问
     ChessEngine& getEngine() { return engine; }
     const ChessEngine& getEngine() const { return engine; }
+    
+    // AI思考期间禁止用户落子
+    void setInputEnabled(bool enabled) { inputEnabled = enabled; }
 
 protected:
     void paintEvent(QPaintEvent *event) override;
@@ -139,6 +143,7 @@ private:
     
     QPoint selectedPos;         // 选中的位置
     bool pieceSelected;         // 是否有棋子被选中
+    bool inputEnabled;          // 是否响应鼠标落子
     QPoint mousePos;            // 鼠标位置
     std::vector<Move> validMoves; // 当前选中棋子的合法走法
     QString gameStatus;         // 游戏状态信息
@@ -236,6 +241,11 @@ private:
     void setupAIEngine();
     void updateAIControls();
     void makeAIMove();
+    void cancelAIThinking();
+    void onAIThinkingFinished();
+    void showAIProgress(const SearchProgress& progress);
+    void resetClocks();
+    void updateClockLabels();
     // void setupUI();
     // void setupMenuBar();
     void setupToolBar();  // 设置工具栏
@@ -294,6 +304,19 @@ private:
     QLabel *redLastMoveLabel;
     QLabel *redRemainingLabel;
     
+    // 对局计时（秒）
+    struct SideClock {
+        double remaining;   // 剩余时间
+        double used;        // 已用时间
+        double lastMove;    // 上一步用时
+    };
+    static constexpr double DEFAULT_GAME_TIME = 600.0;
+    SideClock redClock;
+    SideClock blackClock;
+    double timeIncrement;       // 每步加秒
+    QElapsedTimer turnTimer;    // 当前走棋方本步已用时间
+    QTimer *clockTimer;         // 每秒刷新计时显示
+    
     // 引擎控制组件
     QPushButton *addEngineButton;
     QPushButton *engineManageButton;
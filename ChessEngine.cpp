@@ -1,7 +1,10 @@
 #include "ChessEngine.h"
+#include "PieceSquareTable.h"
 #include <sstream>
 #include <algorithm>
 #include <cmath>
+#include <cstdlib>
+#include <random>
 
 // Move类实现
 std::string Move::toString() const {
@@ -18,8 +21,47 @@ std::string Move::toString() const {
     return ss.str();
 }
 
+// 静态交换评估使用的棋子价值
+static const int SEE_VALUES[15] = {
+    0,
+    10000, 200, 200, 400, 600, 300, 100,
+    10000, 200, 200, 400, 600, 300, 100
+};
+
+// 纵线位图
+static Bitboard makeFileMask(int col) {
+    Bitboard mask;
+    for (int row = 0; row < 10; row++) {
+        mask.set(row * 9 + col);
+    }
+    return mask;
+}
+
+Bitboard ChessEngine::fileMasks[BOARD_COLS] = {
+    makeFileMask(0), makeFileMask(1), makeFileMask(2), makeFileMask(3), makeFileMask(4),
+    makeFileMask(5), makeFileMask(6), makeFileMask(7), makeFileMask(8)
+};
+
+// Zobrist随机数表，使用固定种子，保证不同进程中同一局面的哈希值相同
+struct ZobristKeys {
+    uint64_t pieces[15][90];
+    uint64_t blackToMove;
+    
+    ZobristKeys() {
+        std::mt19937_64 gen(0x9E3779B97F4A7C15ULL);
+        for (int piece = 0; piece < 15; piece++) {
+            for (int sq = 0; sq < 90; sq++) {
+                pieces[piece][sq] = piece == NONE ? 0 : gen();
+            }
+        }
+        blackToMove = gen();
+    }
+};
+
+static const ZobristKeys zobrist;
+
 // ChessEngine类实现
-ChessEngine::ChessEngine() : redToMove(true) {
+ChessEngine::ChessEngine() : redToMove(true), hashKey(0), pawnKey(0), materialScore(0) {
     initializeBoard();
 }
 
@@ -49,7 +91,8 @@ void ChessEngine::initializeBoard() {
     board[7][1] = board[7][7] = RED_CANNON;
     board[6][0] = board[6][2] = board[6][4] = board[6][6] = board[6][8] = RED_PAWN;
     
-    redToMove = true;
+    rebuildPieceSets();
+    setRedTurn(true);
     moveHistory.clear();
 }
 
@@ -59,6 +102,137 @@ void ChessEngine::clearBoard() {
             board[i][j] = NONE;
         }
     }
+    rebuildPieceSets();
+}
+
+void ChessEngine::rebuildPieceSets() {
+    for (int i = 0; i < 15; i++) {
+        pieceBB[i] = Bitboard();
+    }
+    sideBB[0] = sideBB[1] = occupiedBB = Bitboard();
+    pieceCount[0] = pieceCount[1] = 0;
+    kingSquare[0] = kingSquare[1] = -1;
+    hashKey = redToMove ? 0 : zobrist.blackToMove;
+    pawnKey = 0;
+    materialScore = 0;
+    
+    for (int sq = 0; sq < BOARD_SIZE; sq++) {
+        pieceIndex[sq] = 0;
+        PieceType piece = board[rowOf(sq)][colOf(sq)];
+        if (piece != NONE) {
+            board[rowOf(sq)][colOf(sq)] = NONE;
+            addPiece(sq, piece);
+        }
+    }
+    resetPositionHistory();
+}
+
+void ChessEngine::addPiece(int square, PieceType piece) {
+    int side = sideOf(piece);
+    board[rowOf(square)][colOf(square)] = piece;
+    pieceBB[piece].set(square);
+    sideBB[side].set(square);
+    occupiedBB.set(square);
+    hashKey ^= zobrist.pieces[piece][square];
+    if (piece == RED_PAWN || piece == BLACK_PAWN) pawnKey ^= zobrist.pieces[piece][square];
+    materialScore += PieceSquareTable::value(piece, square);
+    
+    pieceIndex[square] = static_cast<uint8_t>(pieceCount[side]);
+    pieceList[side][pieceCount[side]++] = static_cast<uint8_t>(square);
+    
+    if (piece == RED_KING || piece == BLACK_KING) {
+        kingSquare[side] = square;
+    }
+}
+
+void ChessEngine::removePiece(int square) {
+    PieceType piece = board[rowOf(square)][colOf(square)];
+    if (piece == NONE) return;
+    
+    int side = sideOf(piece);
+    board[rowOf(square)][colOf(square)] = NONE;
+    pieceBB[piece].reset(square);
+    sideBB[side].reset(square);
+    occupiedBB.reset(square);
+    hashKey ^= zobrist.pieces[piece][square];
+    if (piece == RED_PAWN || piece == BLACK_PAWN) pawnKey ^= zobrist.pieces[piece][square];
+    materialScore -= PieceSquareTable::value(piece, square);
+    
+    // 用列表末尾的棋子填补空位
+    int index = pieceIndex[square];
+    int lastSquare = pieceList[side][--pieceCount[side]];
+    pieceList[side][index] = static_cast<uint8_t>(lastSquare);
+    pieceIndex[lastSquare] = static_cast<uint8_t>(index);
+    
+    if (piece == RED_KING || piece == BLACK_KING) {
+        kingSquare[side] = pieceBB[piece].any() ? pieceBB[piece].lowest() : -1;
+    }
+}
+
+void ChessEngine::movePiece(int fromSquare, int toSquare) {
+    PieceType piece = board[rowOf(fromSquare)][colOf(fromSquare)];
+    int side = sideOf(piece);
+    
+    board[rowOf(toSquare)][colOf(toSquare)] = piece;
+    board[rowOf(fromSquare)][colOf(fromSquare)] = NONE;
+    
+    Bitboard change;
+    change.set(fromSquare);
+    change.set(toSquare);
+    pieceBB[piece] = pieceBB[piece] ^ change;
+    sideBB[side] = sideBB[side] ^ change;
+    occupiedBB = occupiedBB ^ change;
+    hashKey ^= zobrist.pieces[piece][fromSquare] ^ zobrist.pieces[piece][toSquare];
+    if (piece == RED_PAWN || piece == BLACK_PAWN) {
+        pawnKey ^= zobrist.pieces[piece][fromSquare] ^ zobrist.pieces[piece][toSquare];
+    }
+    materialScore += PieceSquareTable::value(piece, toSquare) - PieceSquareTable::value(piece, fromSquare);
+    
+    int index = pieceIndex[fromSquare];
+    pieceList[side][index] = static_cast<uint8_t>(toSquare);
+    pieceIndex[toSquare] = static_cast<uint8_t>(index);
+    
+    if (piece == RED_KING || piece == BLACK_KING) {
+        kingSquare[side] = toSquare;
+    }
+}
+
+void ChessEngine::refreshMaterialScore() {
+    // 价值表重新加载后，按棋子列表重新累加
+    materialScore = 0;
+    for (int side = 0; side < 2; side++) {
+        for (int i = 0; i < pieceCount[side]; i++) {
+            int sq = pieceList[side][i];
+            materialScore += PieceSquareTable::value(board[rowOf(sq)][colOf(sq)], sq);
+        }
+    }
+}
+
+uint64_t ChessEngine::getBoardKey() const {
+    return redToMove ? hashKey : hashKey ^ zobrist.blackToMove;
+}
+
+void ChessEngine::flipSide() {
+    redToMove = !redToMove;
+    hashKey ^= zobrist.blackToMove;
+}
+
+Bitboard ChessEngine::betweenMask(int fromSquare, int toSquare) {
+    int first = std::min(fromSquare, toSquare);
+    int last = std::max(fromSquare, toSquare);
+    Bitboard mask = Bitboard::range(first + 1, last - 1);
+    
+    // 同一纵线上的格点编号间隔为9，需与纵线位图相交
+    if (colOf(first) == colOf(last) && rowOf(first) != rowOf(last)) {
+        mask &= fileMasks[colOf(first)];
+    }
+    return mask;
+}
+
+Bitboard ChessEngine::aheadMask(int square, bool red) {
+    // 红方朝第0行，黑方朝第9行
+    Bitboard mask = red ? Bitboard::range(0, square - 1) : Bitboard::range(square + 1, BOARD_SIZE - 1);
+    return mask & fileMasks[colOf(square)];
 }
 
 PieceType ChessEngine::getPiece(int row, int col) const {
@@ -68,7 +242,12 @@ PieceType ChessEngine::getPiece(int row, int col) const {
 
 void ChessEngine::setPiece(int row, int col, PieceType piece) {
     if (isInBounds(row, col)) {
-        board[row][col] = piece;
+        int square = squareOf(row, col);
+        removePiece(square);
+        if (piece != NONE) {
+            addPiece(square, piece);
+        }
+        resetPositionHistory();
     }
 }
 
@@ -306,44 +485,13 @@ bool ChessEngine::isValidPawnMove(const Move& move) const {
 }
 
 bool ChessEngine::isPathClear(int fromRow, int fromCol, int toRow, int toCol) const {
-    if (fromRow == toRow && fromCol == toCol) return true;
-    
-    int rowStep = (toRow > fromRow) ? 1 : (toRow < fromRow) ? -1 : 0;
-    int colStep = (toCol > fromCol) ? 1 : (toCol < fromCol) ? -1 : 0;
-    
-    int currentRow = fromRow + rowStep;
-    int currentCol = fromCol + colStep;
-    
-    while (currentRow != toRow || currentCol != toCol) {
-        if (board[currentRow][currentCol] != NONE) {
-            return false;
-        }
-        currentRow += rowStep;
-        currentCol += colStep;
-    }
-    
-    return true;
+    return countPiecesBetween(fromRow, fromCol, toRow, toCol) == 0;
 }
 
 int ChessEngine::countPiecesBetween(int fromRow, int fromCol, int toRow, int toCol) const {
     if (fromRow == toRow && fromCol == toCol) return 0;
     
-    int count = 0;
-    int rowStep = (toRow > fromRow) ? 1 : (toRow < fromRow) ? -1 : 0;
-    int colStep = (toCol > fromCol) ? 1 : (toCol < fromCol) ? -1 : 0;
-    
-    int currentRow = fromRow + rowStep;
-    int currentCol = fromCol + colStep;
-    
-    while (currentRow != toRow || currentCol != toCol) {
-        if (board[currentRow][currentCol] != NONE) {
-            count++;
-        }
-        currentRow += rowStep;
-        currentCol += colStep;
-    }
-    
-    return count;
+    return (occupiedBB & betweenMask(squareOf(fromRow, fromCol), squareOf(toRow, toCol))).count();
 }
 
 bool ChessEngine::makeMove(const Move& move) {
@@ -355,14 +503,17 @@ bool ChessEngine::makeMove(const Move& move) {
     recordMove.capturedPiece = board[move.toRow][move.toCol];
     
     // 执行走法
-    board[move.toRow][move.toCol] = board[move.fromRow][move.fromCol];
-    board[move.fromRow][move.fromCol] = NONE;
+    int fromSquare = squareOf(move.fromRow, move.fromCol);
+    int toSquare = squareOf(move.toRow, move.toCol);
+    removePiece(toSquare);
+    movePiece(fromSquare, toSquare);
     
     // 切换轮次
-    redToMove = !redToMove;
+    flipSide();
     
     // 添加到历史记录
     moveHistory.push_back(recordMove);
+    pushPosition(PackedMove(recordMove));
     
     return true;
 }
@@ -374,48 +525,584 @@ bool ChessEngine::undoMove() {
     moveHistory.pop_back();
     
     // 恢复棋盘状态
-    board[lastMove.fromRow][lastMove.fromCol] = lastMove.movingPiece;
-    board[lastMove.toRow][lastMove.toCol] = lastMove.capturedPiece;
+    int fromSquare = squareOf(lastMove.fromRow, lastMove.fromCol);
+    int toSquare = squareOf(lastMove.toRow, lastMove.toCol);
+    movePiece(toSquare, fromSquare);
+    if (lastMove.capturedPiece != NONE) {
+        addPiece(toSquare, lastMove.capturedPiece);
+    }
     
     // 切换轮次
-    redToMove = !redToMove;
+    flipSide();
+    popPosition();
     
     return true;
 }
 
+void ChessEngine::makeMoveUnchecked(const Move& move, UndoInfo& undo) {
+    int fromSquare = squareOf(move.fromRow, move.fromCol);
+    int toSquare = squareOf(move.toRow, move.toCol);
+    
+    Move recordMove(move.fromRow, move.fromCol, move.toRow, move.toCol,
+                    board[move.fromRow][move.fromCol], board[move.toRow][move.toCol]);
+    undo.move = PackedMove(recordMove);
+    
+    removePiece(toSquare);
+    movePiece(fromSquare, toSquare);
+    flipSide();
+    pushPosition(undo.move);
+}
+
+void ChessEngine::unmakeMove(const UndoInfo& undo) {
+    int fromSquare = undo.move.from();
+    int toSquare = undo.move.to();
+    
+    movePiece(toSquare, fromSquare);
+    if (undo.move.capturedPiece() != NONE) {
+        addPiece(toSquare, undo.move.capturedPiece());
+    }
+    flipSide();
+    popPosition();
+}
+
+void ChessEngine::makeNullMove() {
+    flipSide();
+    pushPosition(PackedMove());
+}
+
+void ChessEngine::unmakeNullMove() {
+    flipSide();
+    popPosition();
+}
+
+void ChessEngine::pushPosition(PackedMove move) {
+    // 吃子、走兵（兵不能后退）与空着之后不可能再回到之前的局面
+    PieceType moving = move.movingPiece();
+    bool irreversible = !move.isValid() || move.capturedPiece() != NONE ||
+                        moving == RED_PAWN || moving == BLACK_PAWN;
+    
+    PositionRecord record;
+    record.key = hashKey;
+    record.move = move;
+    record.reversiblePlies = irreversible ? 0 : positionHistory.back().reversiblePlies + 1;
+    positionHistory.push_back(record);
+}
+
+void ChessEngine::popPosition() {
+    // 设置局面时历史被重置而走法记录保留，之后悔棋退到设置之前时以当前局面重新开始
+    if (positionHistory.size() > 1) {
+        positionHistory.pop_back();
+    } else {
+        resetPositionHistory();
+    }
+}
+
+void ChessEngine::resetPositionHistory() {
+    positionHistory.clear();
+    positionHistory.reserve(512);
+    
+    PositionRecord record;
+    record.key = hashKey;
+    record.reversiblePlies = 0;
+    positionHistory.push_back(record);
+}
+
+int ChessEngine::findRepetition() const {
+    // 键值含走棋方，只需每隔两步比较；至少四步才可能回到同一局面
+    int current = static_cast<int>(positionHistory.size()) - 1;
+    int limit = current - positionHistory[current].reversiblePlies;
+    for (int i = current - 4; i >= limit; i -= 2) {
+        if (positionHistory[i].key == hashKey) return i;
+    }
+    return -1;
+}
+
+int ChessEngine::getRepetitionCount() const {
+    int current = static_cast<int>(positionHistory.size()) - 1;
+    int limit = current - positionHistory[current].reversiblePlies;
+    int count = 0;
+    for (int i = current - 4; i >= limit; i -= 2) {
+        if (positionHistory[i].key == hashKey) count++;
+    }
+    return count;
+}
+
+RepetitionType ChessEngine::getRepetitionType() const {
+    int previous = findRepetition();
+    if (previous < 0) return REPETITION_NONE;
+    
+    // 逐步退回上一次出现时的局面，检查循环中每一步是否将军、是否捉子，最后原样走回
+    ChessEngine* self = const_cast<ChessEngine*>(this);
+    std::vector<PackedMove> cycle;
+    bool allCheck[2] = {true, true};
+    bool allChase[2] = {true, true};
+    for (int i = static_cast<int>(positionHistory.size()) - 1; i > previous; i--) {
+        PackedMove move = positionHistory[i].move;
+        int mover = sideOf(move.movingPiece());
+        if (!isInCheck(mover == 1)) allCheck[mover] = false;
+        if (!isChasingMove(move)) allChase[mover] = false;
+        
+        cycle.push_back(move);
+        UndoInfo undo;
+        undo.move = move;
+        self->unmakeMove(undo);
+    }
+    for (auto it = cycle.rbegin(); it != cycle.rend(); ++it) {
+        UndoInfo undo;
+        self->makeMoveUnchecked(it->toMove(), undo);
+    }
+    
+    // 长将优先于长捉；双方同时违例按和棋处理
+    int us = redToMove ? 0 : 1;
+    int them = 1 - us;
+    if (allCheck[us] != allCheck[them]) {
+        return allCheck[us] ? REPETITION_PERPETUAL_CHECK : REPETITION_OPPONENT_CHECK;
+    }
+    if (!allCheck[us] && allChase[us] != allChase[them]) {
+        return allChase[us] ? REPETITION_PERPETUAL_CHASE : REPETITION_OPPONENT_CHASE;
+    }
+    return REPETITION_DRAW;
+}
+
+bool ChessEngine::isChasingMove(PackedMove move) const {
+    // 将帅与兵卒捉子不算捉
+    int fromSquare = move.from();
+    int toSquare = move.to();
+    PieceType piece = board[rowOf(toSquare)][colOf(toSquare)];
+    if (piece == RED_KING || piece == BLACK_KING || piece == RED_PAWN || piece == BLACK_PAWN) return false;
+    
+    // 走后的棋子能吃到对方无根的子，或以马、炮、仕、相捉车（有根的车也算）；
+    // 有根的其他子即使价值高于攻击者也不算捉。未过河的兵卒不算被捉
+    bool moverRed = sideOf(piece) == 0;
+    int targetSide = moverRed ? 1 : 0;
+    int chased[16];
+    int chasedCount = 0;
+    for (int i = 0; i < pieceCount[targetSide]; i++) {
+        int square = pieceList[targetSide][i];
+        PieceType target = board[rowOf(square)][colOf(square)];
+        if (target == RED_KING || target == BLACK_KING) continue;
+        if (target == RED_PAWN && rowOf(square) >= 5) continue;
+        if (target == BLACK_PAWN && rowOf(square) <= 4) continue;
+        
+        int attackers[16];
+        int attackerCount = collectAttackers(square, moverRed, attackers);
+        if (std::find(attackers, attackers + attackerCount, toSquare) == attackers + attackerCount) continue;
+        
+        bool rookByLesser = (target == RED_ROOK || target == BLACK_ROOK) && SEE_VALUES[piece] < SEE_VALUES[target];
+        if (rookByLesser || !isSquareAttacked(square, !moverRed)) {
+            chased[chasedCount++] = square;
+        }
+    }
+    if (chasedCount == 0) return false;
+    
+    // 只有这步新产生的攻击才算捉：在棋盘数组上临时退回走前局面，原位置已能吃到的目标不算
+    ChessEngine* self = const_cast<ChessEngine*>(this);
+    self->board[rowOf(toSquare)][colOf(toSquare)] = move.capturedPiece();
+    self->board[rowOf(fromSquare)][colOf(fromSquare)] = piece;
+    
+    bool newAttack = false;
+    for (int i = 0; i < chasedCount && !newAttack; i++) {
+        int attackers[16];
+        int attackerCount = collectAttackers(chased[i], moverRed, attackers);
+        newAttack = std::find(attackers, attackers + attackerCount, fromSquare) == attackers + attackerCount;
+    }
+    
+    self->board[rowOf(fromSquare)][colOf(fromSquare)] = NONE;
+    self->board[rowOf(toSquare)][colOf(toSquare)] = piece;
+    
+    return newAttack;
+}
+
 bool ChessEngine::isInCheck(bool isRed) const {
-    // 找到王的位置
-    int kingRow = -1, kingCol = -1;
-    PieceType targetKing = isRed ? RED_KING : BLACK_KING;
-    
-    for (int r = 0; r < BOARD_ROWS; r++) {
-        for (int c = 0; c < BOARD_COLS; c++) {
-            if (board[r][c] == targetKing) {
-                kingRow = r;
-                kingCol = c;
-                break;
+    // 王的位置已缓存，直接从王所在格反向探测
+    int king = getKingSquare(isRed);
+    if (king < 0) return false; // 没有找到王
+    
+    return isSquareAttacked(king, !isRed);
+}
+
+bool ChessEngine::isSquareAttacked(int square, bool byRed) const {
+    // 不收集攻击者时找到第一个即返回
+    return collectAttackers(square, byRed, nullptr) > 0;
+}
+
+int ChessEngine::collectAttackers(int square, bool byRed, int attackers[]) const {
+    int row = rowOf(square), col = colOf(square);
+    PieceType rook = byRed ? RED_ROOK : BLACK_ROOK;
+    PieceType cannon = byRed ? RED_CANNON : BLACK_CANNON;
+    PieceType knight = byRed ? RED_KNIGHT : BLACK_KNIGHT;
+    PieceType pawn = byRed ? RED_PAWN : BLACK_PAWN;
+    PieceType king = byRed ? RED_KING : BLACK_KING;
+    PieceType target = board[row][col];
+    bool targetIsKing = (target == RED_KING || target == BLACK_KING);
+    int count = 0;
+    
+    // 记录一个攻击者，只判断是否受攻击时返回true以立即结束
+    auto found = [&](int r, int c) {
+        if (attackers) attackers[count] = squareOf(r, c);
+        count++;
+        return attackers == nullptr;
+    };
+    
+    // 车、炮及将帅对面：沿四个方向找第一、第二个棋子（炮架随吃子过程实时变化）
+    static const int lineDirs[4][2] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}};
+    for (int d = 0; d < 4; d++) {
+        int r = row + lineDirs[d][0], c = col + lineDirs[d][1];
+        while (isInBounds(r, c) && board[r][c] == NONE) {
+            r += lineDirs[d][0];
+            c += lineDirs[d][1];
+        }
+        if (!isInBounds(r, c)) continue;
+        
+        PieceType first = board[r][c];
+        if (first == rook && found(r, c)) return count;
+        if (first == king && targetIsKing && lineDirs[d][1] == 0 && found(r, c)) return count;
+        
+        do {
+            r += lineDirs[d][0];
+            c += lineDirs[d][1];
+        } while (isInBounds(r, c) && board[r][c] == NONE);
+        if (isInBounds(r, c) && board[r][c] == cannon && found(r, c)) return count;
+    }
+    
+    // 马：马腿必定位于目标格的斜邻格，被蹩腿的马不算
+    static const int diagDirs[4][2] = {{-1, -1}, {-1, 1}, {1, -1}, {1, 1}};
+    for (int d = 0; d < 4; d++) {
+        int legRow = row + diagDirs[d][0], legCol = col + diagDirs[d][1];
+        if (!isInBounds(legRow, legCol) || board[legRow][legCol] != NONE) continue;
+        
+        int r1 = row + 2 * diagDirs[d][0], c1 = col + diagDirs[d][1];
+        int r2 = row + diagDirs[d][0], c2 = col + 2 * diagDirs[d][1];
+        if (isInBounds(r1, c1) && board[r1][c1] == knight && found(r1, c1)) return count;
+        if (isInBounds(r2, c2) && board[r2][c2] == knight && found(r2, c2)) return count;
+    }
+    
+    // 兵/卒：正面一格，过河后还有左右两格
+    int forward = byRed ? 1 : -1;
+    if (isInBounds(row + forward, col) && board[row + forward][col] == pawn && found(row + forward, col)) return count;
+    if (byRed ? row <= 4 : row >= 5) {
+        if (col > 0 && board[row][col - 1] == pawn && found(row, col - 1)) return count;
+        if (col < BOARD_COLS - 1 && board[row][col + 1] == pawn && found(row, col + 1)) return count;
+    }
+    
+    // 士、象、帅/将只能攻击本方区域内的格点
+    bool inPalace = col >= 3 && col <= 5 && (byRed ? row >= 7 : row <= 2);
+    bool onOwnSide = byRed ? row >= 5 : row <= 4;
+    if (inPalace) {
+        PieceType advisor = byRed ? RED_ADVISOR : BLACK_ADVISOR;
+        for (int d = 0; d < 4; d++) {
+            int r = row + diagDirs[d][0], c = col + diagDirs[d][1];
+            if (isInBounds(r, c) && board[r][c] == advisor && found(r, c)) return count;
+        }
+        for (int d = 0; d < 4; d++) {
+            int r = row + lineDirs[d][0], c = col + lineDirs[d][1];
+            if (isInBounds(r, c) && board[r][c] == king && found(r, c)) return count;
+        }
+    }
+    if (onOwnSide) {
+        PieceType bishop = byRed ? RED_BISHOP : BLACK_BISHOP;
+        for (int d = 0; d < 4; d++) {
+            int r = row + 2 * diagDirs[d][0], c = col + 2 * diagDirs[d][1];
+            if (isInBounds(r, c) && board[r][c] == bishop &&
+                board[row + diagDirs[d][0]][col + diagDirs[d][1]] == NONE && found(r, c)) {
+                return count;
+            }
+        }
+    }
+    
+    return count;
+}
+
+int ChessEngine::staticExchange(const Move& move) const {
+    // 只在棋盘数组上模拟交换，结束后原样恢复
+    ChessEngine* self = const_cast<ChessEngine*>(this);
+    int fromSquare = squareOf(move.fromRow, move.fromCol);
+    int target = squareOf(move.toRow, move.toCol);
+    PieceType moving = board[move.fromRow][move.fromCol];
+    PieceType captured = board[move.toRow][move.toCol];
+    
+    int kings[2] = {kingSquare[0], kingSquare[1]};
+    if (moving == RED_KING || moving == BLACK_KING) kings[sideOf(moving)] = target;
+    
+    int removed[32];
+    PieceType removedPieces[32];
+    int removedCount = 0;
+    
+    self->board[move.fromRow][move.fromCol] = NONE;
+    self->board[move.toRow][move.toCol] = moving;
+    removed[removedCount] = fromSquare;
+    removedPieces[removedCount++] = moving;
+    
+    int gain[32];
+    int depth = 0;
+    gain[0] = SEE_VALUES[captured];
+    int attackerValue = SEE_VALUES[moving];
+    bool redToCapture = sideOf(moving) == 1;
+    
+    while (depth < 31) {
+        // 选出价值最小且走后不造成将帅对面的吃子方
+        int attackers[16];
+        int attackerCount = collectAttackers(target, redToCapture, attackers);
+        std::sort(attackers, attackers + attackerCount, [&](int a, int b) {
+            return SEE_VALUES[board[rowOf(a)][colOf(a)]] < SEE_VALUES[board[rowOf(b)][colOf(b)]];
+        });
+        
+        int chosen = -1;
+        PieceType previous = board[rowOf(target)][colOf(target)];
+        for (int i = 0; i < attackerCount && chosen < 0; i++) {
+            int sq = attackers[i];
+            PieceType piece = board[rowOf(sq)][colOf(sq)];
+            int side = sideOf(piece);
+            int savedKing = kings[side];
+            
+            self->board[rowOf(sq)][colOf(sq)] = NONE;
+            self->board[rowOf(target)][colOf(target)] = piece;
+            if (piece == RED_KING || piece == BLACK_KING) kings[side] = target;
+            
+            // 将帅对面的吃法不合法
+            if (isKingFacingKing(kings[0], kings[1])) {
+                self->board[rowOf(sq)][colOf(sq)] = piece;
+                self->board[rowOf(target)][colOf(target)] = previous;
+                kings[side] = savedKing;
+            } else {
+                chosen = sq;
+                removed[removedCount] = sq;
+                removedPieces[removedCount++] = piece;
             }
         }
-        if (kingRow != -1) break;
+        if (chosen < 0) break;
+        
+        depth++;
+        gain[depth] = attackerValue - gain[depth - 1];
+        attackerValue = SEE_VALUES[board[rowOf(target)][colOf(target)]];
+        redToCapture = !redToCapture;
     }
     
-    if (kingRow == -1) return false; // 没有找到王
+    // 反向求极小极大：每一方都可以选择不继续吃
+    for (; depth > 0; depth--) {
+        gain[depth - 1] = -std::max(-gain[depth - 1], gain[depth]);
+    }
     
-    // 检查是否有敌方棋子可以攻击到王
-    for (int r = 0; r < BOARD_ROWS; r++) {
-        for (int c = 0; c < BOARD_COLS; c++) {
-            PieceType piece = board[r][c];
-            if (piece != NONE && ((isRed && isBlack(piece)) || (!isRed && this->isRed(piece)))) {
-                Move attackMove(r, c, kingRow, kingCol, piece, targetKing);
-                // 临时检查走法，不考虑将军状态
-                if (isValidMoveIgnoreCheck(attackMove)) {
-                    return true;
+    // 恢复棋盘
+    self->board[move.toRow][move.toCol] = captured;
+    for (int i = removedCount - 1; i >= 0; i--) {
+        self->board[rowOf(removed[i])][colOf(removed[i])] = removedPieces[i];
+    }
+    
+    return gain[0];
+}
+
+bool ChessEngine::isNearKing(int square, int kingSquare) {
+    // 起点和终点都不在对方将的横线、纵线或5×5邻域内时，走法不可能将军
+    int row = rowOf(square), col = colOf(square);
+    int kingRow = rowOf(kingSquare), kingCol = colOf(kingSquare);
+    return row == kingRow || col == kingCol ||
+           (std::abs(row - kingRow) <= 2 && std::abs(col - kingCol) <= 2);
+}
+
+bool ChessEngine::givesCheck(const Move& move) const {
+    PieceType moving = board[move.fromRow][move.fromCol];
+    bool red = sideOf(moving) == 0;
+    int enemyKing = kingSquare[red ? 1 : 0];
+    if (enemyKing < 0) return false;
+    
+    if (!isNearKing(squareOf(move.fromRow, move.fromCol), enemyKing) &&
+        !isNearKing(squareOf(move.toRow, move.toCol), enemyKing)) return false;
+    
+    // 只在棋盘数组上临时移动棋子，攻击探测完成后恢复
+    ChessEngine* self = const_cast<ChessEngine*>(this);
+    PieceType captured = board[move.toRow][move.toCol];
+    self->board[move.fromRow][move.fromCol] = NONE;
+    self->board[move.toRow][move.toCol] = moving;
+    
+    bool check = isSquareAttacked(enemyKing, red);
+    
+    self->board[move.toRow][move.toCol] = captured;
+    self->board[move.fromRow][move.fromCol] = moving;
+    
+    return check;
+}
+
+void ChessEngine::buildAttackMap(AttackMap& map) const {
+    static const int ORTHOGONAL[4][2] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}};
+    static const int DIAGONAL[4][2] = {{-1, -1}, {-1, 1}, {1, -1}, {1, 1}};
+    // 马腿方向及其对应的两个落点
+    static const int KNIGHT_TARGETS[4][2][2] = {
+        {{-2, -1}, {-2, 1}}, {{2, -1}, {2, 1}}, {{-1, -2}, {1, -2}}, {{-1, 2}, {1, 2}}
+    };
+    
+    std::fill(&map.count[0][0], &map.count[0][0] + 2 * BOARD_SIZE, 0);
+    map.mobility[0] = map.mobility[1] = 0;
+    
+    for (int side = 0; side < 2; side++) {
+        uint8_t* count = map.count[side];
+        int& mobility = map.mobility[side];
+        bool red = side == 0;
+        
+        for (int i = 0; i < pieceCount[side]; i++) {
+            int sq = pieceList[side][i];
+            int row = rowOf(sq);
+            int col = colOf(sq);
+            PieceType piece = board[row][col];
+            PieceType kind = red ? piece : static_cast<PieceType>(piece - BLACK_KING + RED_KING);
+            
+            switch (kind) {
+            case RED_ROOK:
+            case RED_CANNON:
+                for (int d = 0; d < 4; d++) {
+                    int r = row + ORTHOGONAL[d][0];
+                    int c = col + ORTHOGONAL[d][1];
+                    
+                    // 射线上的空格都可到达，车同时控制这些格点
+                    while (isInBounds(r, c) && board[r][c] == NONE) {
+                        mobility++;
+                        if (kind == RED_ROOK) count[squareOf(r, c)]++;
+                        r += ORTHOGONAL[d][0];
+                        c += ORTHOGONAL[d][1];
+                    }
+                    if (!isInBounds(r, c)) continue;
+                    
+                    // 车攻击第一个棋子；炮越过炮架，攻击其后的空格直到第一个棋子
+                    if (kind == RED_CANNON) {
+                        r += ORTHOGONAL[d][0];
+                        c += ORTHOGONAL[d][1];
+                        while (isInBounds(r, c) && board[r][c] == NONE) {
+                            count[squareOf(r, c)]++;
+                            r += ORTHOGONAL[d][0];
+                            c += ORTHOGONAL[d][1];
+                        }
+                        if (!isInBounds(r, c)) continue;
+                    }
+                    count[squareOf(r, c)]++;
+                    if (sideOf(board[r][c]) != side) mobility++;
+                }
+                break;
+                
+            case RED_KNIGHT:
+                for (int leg = 0; leg < 4; leg++) {
+                    int legRow = row + ORTHOGONAL[leg][0];
+                    int legCol = col + ORTHOGONAL[leg][1];
+                    if (!isInBounds(legRow, legCol) || board[legRow][legCol] != NONE) continue;
+                    
+                    for (int t = 0; t < 2; t++) {
+                        int r = row + KNIGHT_TARGETS[leg][t][0];
+                        int c = col + KNIGHT_TARGETS[leg][t][1];
+                        if (!isInBounds(r, c)) continue;
+                        count[squareOf(r, c)]++;
+                        if (board[r][c] == NONE || sideOf(board[r][c]) != side) mobility++;
+                    }
+                }
+                break;
+                
+            case RED_PAWN: {
+                int forward = red ? row - 1 : row + 1;
+                if (forward >= 0 && forward < BOARD_ROWS) count[squareOf(forward, col)]++;
+                
+                // 过河后可以横走
+                if (red ? row <= 4 : row >= 5) {
+                    if (col > 0) count[squareOf(row, col - 1)]++;
+                    if (col < BOARD_COLS - 1) count[squareOf(row, col + 1)]++;
                 }
+                break;
+            }
+                
+            case RED_ADVISOR:
+            case RED_KING:
+                // 仕斜走、帅直走，都不能出九宫
+                for (int d = 0; d < 4; d++) {
+                    int r = row + (kind == RED_ADVISOR ? DIAGONAL[d][0] : ORTHOGONAL[d][0]);
+                    int c = col + (kind == RED_ADVISOR ? DIAGONAL[d][1] : ORTHOGONAL[d][1]);
+                    bool inPalace = c >= 3 && c <= 5 && (red ? r >= 7 && r <= 9 : r >= 0 && r <= 2);
+                    if (inPalace) count[squareOf(r, c)]++;
+                }
+                break;
+                
+            case RED_BISHOP:
+                // 相走田字，象眼不能被塞，不能过河
+                for (int d = 0; d < 4; d++) {
+                    int r = row + 2 * DIAGONAL[d][0];
+                    int c = col + 2 * DIAGONAL[d][1];
+                    bool ownHalf = red ? r >= 5 && r <= 9 : r >= 0 && r <= 4;
+                    if (ownHalf && c >= 0 && c < BOARD_COLS &&
+                        board[row + DIAGONAL[d][0]][col + DIAGONAL[d][1]] == NONE) {
+                        count[squareOf(r, c)]++;
+                    }
+                }
+                break;
+                
+            default:
+                break;
             }
         }
     }
+}
+
+void ChessEngine::computeKingShields(bool forRed, Bitboard& pinned, Bitboard& screens) const {
+    pinned = Bitboard();
+    screens = Bitboard();
+    
+    int king = getKingSquare(forRed);
+    if (king < 0) return;
+    
+    int row = rowOf(king), col = colOf(king);
+    const Bitboard& own = sideBB[forRed ? 0 : 1];
+    PieceType enemyRook = forRed ? BLACK_ROOK : RED_ROOK;
+    PieceType enemyCannon = forRed ? BLACK_CANNON : RED_CANNON;
+    PieceType enemyKing = forRed ? BLACK_KING : RED_KING;
+    
+    static const int lineDirs[4][2] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}};
+    for (int d = 0; d < 4; d++) {
+        // 沿射线记录前三个棋子以及第一个棋子之前的空格
+        int hits[3] = {-1, -1, -1};
+        Bitboard emptyRun;
+        int found = 0;
+        int r = row + lineDirs[d][0], c = col + lineDirs[d][1];
+        while (isInBounds(r, c) && found < 3) {
+            if (board[r][c] != NONE) {
+                hits[found++] = squareOf(r, c);
+            } else if (found == 0) {
+                emptyRun.set(squareOf(r, c));
+            }
+            r += lineDirs[d][0];
+            c += lineDirs[d][1];
+        }
+        if (found == 0) continue;
+        
+        auto pieceOn = [this](int sq) { return sq < 0 ? NONE : board[rowOf(sq)][colOf(sq)]; };
+        PieceType first = pieceOn(hits[0]), second = pieceOn(hits[1]), third = pieceOn(hits[2]);
+        bool vertical = lineDirs[d][1] == 0;
+        
+        // 紧贴敌炮的空格一旦落子就成了炮架
+        if (first == enemyCannon) {
+            screens |= emptyRun;
+        }
+        // 车、对面将帅身前的唯一遮挡，或敌炮身前的两个遮挡之一
+        if (own.test(hits[0]) && (second == enemyRook || (vertical && second == enemyKing) || third == enemyCannon)) {
+            pinned.set(hits[0]);
+        }
+        if (hits[1] >= 0 && own.test(hits[1]) && third == enemyCannon) {
+            pinned.set(hits[1]);
+        }
+    }
     
-    return false;
+    // 王的斜邻格是所有攻王之马的马腿
+    static const int diagDirs[4][2] = {{-1, -1}, {-1, 1}, {1, -1}, {1, 1}};
+    for (int d = 0; d < 4; d++) {
+        int r = row + diagDirs[d][0], c = col + diagDirs[d][1];
+        if (isInBounds(r, c) && own.test(squareOf(r, c))) {
+            pinned.set(squareOf(r, c));
+        }
+    }
+}
+
+bool ChessEngine::isKingFacingKing(int redKing, int blackKing) const {
+    // 直接读棋盘数组，交换评估在数组上临时走子时也能使用
+    if (redKing < 0 || blackKing < 0 || colOf(redKing) != colOf(blackKing)) return false;
+    
+    for (int r = rowOf(blackKing) + 1; r < rowOf(redKing); r++) {
+        if (board[r][colOf(redKing)] != NONE) return false;
+    }
+    return true;
 }
 
 bool ChessEngine::isValidMoveIgnoreCheck(const Move& move) const {
@@ -459,72 +1146,117 @@ bool ChessEngine::isValidMoveIgnoreCheck(const Move& move) const {
 
 bool ChessEngine::wouldBeInCheck(const Move& move, bool isRed) const {
     // 临时执行走法
+    ChessEngine* self = const_cast<ChessEngine*>(this);
+    int fromSquare = squareOf(move.fromRow, move.fromCol);
+    int toSquare = squareOf(move.toRow, move.toCol);
     PieceType originalPiece = board[move.toRow][move.toCol];
-    const_cast<ChessEngine*>(this)->board[move.toRow][move.toCol] = board[move.fromRow][move.fromCol];
-    const_cast<ChessEngine*>(this)->board[move.fromRow][move.fromCol] = NONE;
+    self->removePiece(toSquare);
+    self->movePiece(fromSquare, toSquare);
     
     bool inCheck = isInCheck(isRed);
     
     // 恢复棋盘
-    const_cast<ChessEngine*>(this)->board[move.fromRow][move.fromCol] = board[move.toRow][move.toCol];
-    const_cast<ChessEngine*>(this)->board[move.toRow][move.toCol] = originalPiece;
+    self->movePiece(toSquare, fromSquare);
+    if (originalPiece != NONE) {
+        self->addPiece(toSquare, originalPiece);
+    }
     
     return inCheck;
 }
 
 std::vector<Move> ChessEngine::generateLegalMoves(bool forRed) const {
-    std::vector<Move> moves;
-    
-    for (int r = 0; r < BOARD_ROWS; r++) {
-        for (int c = 0; c < BOARD_COLS; c++) {
-            PieceType piece = board[r][c];
-            if (piece != NONE && ((forRed && isRed(piece)) || (!forRed && isBlack(piece)))) {
-                switch (piece) {
-                    case RED_KING:
-                    case BLACK_KING:
-                        generateKingMoves(r, c, moves);
-                        break;
-                    case RED_ADVISOR:
-                    case BLACK_ADVISOR:
-                        generateAdvisorMoves(r, c, moves);
-                        break;
-                    case RED_BISHOP:
-                    case BLACK_BISHOP:
-                        generateBishopMoves(r, c, moves);
-                        break;
-                    case RED_KNIGHT:
-                    case BLACK_KNIGHT:
-                        generateKnightMoves(r, c, moves);
-                        break;
-                    case RED_ROOK:
-                    case BLACK_ROOK:
-                        generateRookMoves(r, c, moves);
-                        break;
-                    case RED_CANNON:
-                    case BLACK_CANNON:
-                        generateCannonMoves(r, c, moves);
-                        break;
-                    case RED_PAWN:
-                    case BLACK_PAWN:
-                        generatePawnMoves(r, c, moves);
-                        break;
-                }
-            }
+    MoveList moves;
+    generateMoves(forRed, moves, GEN_ALL);
+    return std::vector<Move>(moves.begin(), moves.end());
+}
+
+void ChessEngine::generateLegalMoves(bool forRed, MoveList& moves) const {
+    generateMoves(forRed, moves, GEN_ALL);
+}
+
+void ChessEngine::generateLegalCaptures(bool forRed, MoveList& moves) const {
+    generateMoves(forRed, moves, GEN_CAPTURES);
+}
+
+void ChessEngine::generateQuietCheckCandidates(bool forRed, MoveList& moves) const {
+    generateMoves(forRed, moves, GEN_QUIET_CHECKS);
+}
+
+void ChessEngine::generateMoves(bool forRed, MoveList& moves, MoveGenType type) const {
+    moves.clear();
+    
+    int enemyKing = kingSquare[forRed ? 1 : 0];
+    if (type == GEN_QUIET_CHECKS && enemyKing < 0) return;
+    
+    // 遍历本方棋子列表
+    int side = forRed ? 0 : 1;
+    for (int i = 0; i < pieceCount[side]; i++) {
+        int r = rowOf(pieceList[side][i]);
+        int c = colOf(pieceList[side][i]);
+        switch (board[r][c]) {
+            case RED_KING:
+            case BLACK_KING:
+                generateKingMoves(r, c, moves);
+                break;
+            case RED_ADVISOR:
+            case BLACK_ADVISOR:
+                generateAdvisorMoves(r, c, moves);
+                break;
+            case RED_BISHOP:
+            case BLACK_BISHOP:
+                generateBishopMoves(r, c, moves);
+                break;
+            case RED_KNIGHT:
+            case BLACK_KNIGHT:
+                generateKnightMoves(r, c, moves);
+                break;
+            case RED_ROOK:
+            case BLACK_ROOK:
+                generateRookMoves(r, c, moves);
+                break;
+            case RED_CANNON:
+            case BLACK_CANNON:
+                generateCannonMoves(r, c, moves);
+                break;
+            case RED_PAWN:
+            case BLACK_PAWN:
+                generatePawnMoves(r, c, moves);
+                break;
+            default:
+                break;
         }
     }
     
-    // 过滤掉会导致自己被将军的走法
-    std::vector<Move> legalMoves;
-    for (const Move& move : moves) {
-        if (!wouldBeInCheck(move, forRed)) {
-            legalMoves.push_back(move);
-        }
+    // 每个节点只计算一次将军与牵制信息
+    int king = getKingSquare(forRed);
+    bool inCheck = king >= 0 && isSquareAttacked(king, !forRed);
+    Bitboard pinned, screens;
+    if (king >= 0 && !inCheck) {
+        computeKingShields(forRed, pinned, screens);
     }
     
-    return legalMoves;
+    // 未被将军时，只有王、被牵制棋子和落在炮架位置上的走法需要实际验证
+    // 合法走法原地压缩到列表前部
+    int legalCount = 0;
+    for (int i = 0; i < moves.size(); i++) {
+        const Move& move = moves[i];
+        int fromSquare = squareOf(move.fromRow, move.fromCol);
+        int toSquare = squareOf(move.toRow, move.toCol);
+        if (type == GEN_CAPTURES && board[move.toRow][move.toCol] == NONE) continue;
+        // 将军候选与givesCheck用同一预筛（士、象走到对方将所在线上也可能成为炮架）
+        if (type == GEN_QUIET_CHECKS && (board[move.toRow][move.toCol] != NONE ||
+            (!isNearKing(fromSquare, enemyKing) && !isNearKing(toSquare, enemyKing)))) continue;
+        
+        bool needsProbe = king >= 0 &&
+            (inCheck || fromSquare == king || pinned.test(fromSquare) || screens.test(toSquare));
+        if (!needsProbe || !wouldBeInCheck(move, forRed)) {
+            moves[legalCount++] = move;
+        }
+    }
+    moves.resize(legalCount);
 }
 
-void ChessEngine::generateKingMoves(int row, int col, std::vector<Move>& moves) const {
+void ChessEngine::generateKingMoves(int row, int col, MoveList& moves) const {
     // 帅/将的移动方向
     int directions[4][2] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}};
     
@@ -539,7 +1271,7 @@ void ChessEngine::generateKingMoves(int row, int col, std::vector<Move>& moves)
     }
 }
 
-void ChessEngine::generateAdvisorMoves(int row, int col, std::vector<Move>& moves) const {
+void ChessEngine::generateAdvisorMoves(int row, int col, MoveList& moves) const {
     // 士的移动方向（斜向）
     int directions[4][2] = {{-1, -1}, {-1, 1}, {1, -1}, {1, 1}};
     
@@ -554,7 +1286,7 @@ void ChessEngine::generateAdvisorMoves(int row, int col, std::vector<Move>& move
     }
 }
 
-void ChessEngine::generateBishopMoves(int row, int col, std::vector<Move>& moves) const {
+void ChessEngine::generateBishopMoves(int row, int col, MoveList& moves) const {
     // 象的移动方向
     int directions[4][2] = {{-2, -2}, {-2, 2}, {2, -2}, {2, 2}};
     
@@ -569,7 +1301,7 @@ void ChessEngine::generateBishopMoves(int row, int col, std::vector<Move>& moves
     }
 }
 
-void ChessEngine::generateKnightMoves(int row, int col, std::vector<Move>& moves) const {
+void ChessEngine::generateKnightMoves(int row, int col, MoveList& moves) const {
     // 马的移动方向
     int directions[8][2] = {{-2, -1}, {-2, 1}, {-1, -2}, {-1, 2}, {1, -2}, {1, 2}, {2, -1}, {2, 1}};
     
@@ -584,7 +1316,7 @@ void ChessEngine::generateKnightMoves(int row, int col, std::vector<Move>& moves
     }
 }
 
-void ChessEngine::generateRookMoves(int row, int col, std::vector<Move>& moves) const {
+void ChessEngine::generateRookMoves(int row, int col, MoveList& moves) const {
     // 车的移动方向
     int directions[4][2] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}};
     
@@ -608,7 +1340,7 @@ void ChessEngine::generateRookMoves(int row, int col, std::vector<Move>& moves)
     }
 }
 
-void ChessEngine::generateCannonMoves(int row, int col, std::vector<Move>& moves) const {
+void ChessEngine::generateCannonMoves(int row, int col, MoveList& moves) const {
     // 炮的移动方向
     int directions[4][2] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}};
     
@@ -642,7 +1374,7 @@ void ChessEngine::generateCannonMoves(int row, int col, std::vector<Move>& moves
     }
 }
 
-void ChessEngine::generatePawnMoves(int row, int col, std::vector<Move>& moves) const {
+void ChessEngine::generatePawnMoves(int row, int col, MoveList& moves) const {
     PieceType pawn = board[row][col];
     
     if (isRed(pawn)) {
@@ -699,14 +1431,16 @@ void ChessEngine::generatePawnMoves(int row, int col, std::vector<Move>& moves)
 bool ChessEngine::isCheckmate(bool isRed) const {
     if (!isInCheck(isRed)) return false;
     
-    std::vector<Move> legalMoves = generateLegalMoves(isRed);
+    MoveList legalMoves;
+    generateLegalMoves(isRed, legalMoves);
     return legalMoves.empty();
 }
 
 bool ChessEngine::isStalemate(bool isRed) const {
     if (isInCheck(isRed)) return false;
     
-    std::vector<Move> legalMoves = generateLegalMoves(isRed);
+    MoveList legalMoves;
+    generateLegalMoves(isRed, legalMoves);
     return legalMoves.empty();
 }
 
@@ -797,12 +1531,13 @@ bool ChessEngine::fromFEN(const std::string& fenStr) {
             }
             
             if (row >= BOARD_ROWS || col >= BOARD_COLS) return false;
-            board[row][col] = piece;
+            addPiece(squareOf(row, col), piece);
             col++;
         }
     }
     
-    redToMove = (turn == "w");
+    setRedTurn(turn == "w");
+    resetPositionHistory();
     return true;
 }
 
@@ -820,4 +1555,5 @@ void ChessEngine::setBoard(const PieceType srcBoard[10][9]) {
             board[i][j] = srcBoard[i][j];
         }
     }
+    rebuildPieceSets();
 }
\ No newline at end of file
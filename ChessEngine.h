@@ -4,6 +4,11 @@
 #include <vector>
 #include <string>
 #include <stack>
+#include <cstdint>
+#include <new>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
 
 // 棋子类型枚举（与Chess.h保持一致）
 enum PieceType {
@@ -12,6 +17,16 @@ enum PieceType {
     BLACK_KING = 8, BLACK_ADVISOR = 9, BLACK_BISHOP = 10, BLACK_KNIGHT = 11, BLACK_ROOK = 12, BLACK_CANNON = 13, BLACK_PAWN = 14
 };
 
+// 重复局面的裁决结果（对当前走棋方而言）
+enum RepetitionType {
+    REPETITION_NONE,              // 没有重复
+    REPETITION_DRAW,              // 双方均未长将长捉（或双方同时违例），判和
+    REPETITION_PERPETUAL_CHECK,   // 走棋方长将，判负
+    REPETITION_PERPETUAL_CHASE,   // 走棋方长捉，判负
+    REPETITION_OPPONENT_CHECK,    // 对方长将，走棋方胜
+    REPETITION_OPPONENT_CHASE     // 对方长捉，走棋方胜
+};
+
 // 走法结构
 struct Move {
     int fromRow, fromCol;
@@ -27,6 +42,153 @@ struct Move {
     std::string toString() const;
 };
 
+// 紧凑走法编码（32位）
+//   bit 0-6   起点格（row * 9 + col，0..89）
+//   bit 7-13  终点格
+//   bit 14-17 走子
+//   bit 18-21 被吃子
+// 低14位即可唯一确定一步走法，用于置换表、杀手表等需要缓存友好的场合
+struct PackedMove {
+    uint32_t data;
+    
+    PackedMove() : data(0) {}
+    explicit PackedMove(const Move& move)
+        : data(move.isValid()
+               ? static_cast<uint32_t>(move.fromRow * 9 + move.fromCol)
+                 | static_cast<uint32_t>(move.toRow * 9 + move.toCol) << 7
+                 | static_cast<uint32_t>(move.movingPiece) << 14
+                 | static_cast<uint32_t>(move.capturedPiece) << 18
+               : 0) {}
+    
+    int from() const { return data & 0x7F; }
+    int to() const { return (data >> 7) & 0x7F; }
+    PieceType movingPiece() const { return static_cast<PieceType>((data >> 14) & 0xF); }
+    PieceType capturedPiece() const { return static_cast<PieceType>((data >> 18) & 0xF); }
+    
+    // 仅含起点和终点的16位形式
+    uint16_t move16() const { return static_cast<uint16_t>(data & 0x3FFF); }
+    static PackedMove fromMove16(uint16_t value) { PackedMove move; move.data = value & 0x3FFF; return move; }
+    
+    // 起点与终点不可能重合，因此0表示无效走法
+    bool isValid() const { return data != 0; }
+    
+    Move toMove() const {
+        if (!isValid()) return Move();
+        return Move(from() / 9, from() % 9, to() / 9, to() % 9, movingPiece(), capturedPiece());
+    }
+    std::string toString() const { return toMove().toString(); }
+    
+    // 只比较起点和终点
+    bool operator==(const PackedMove& other) const { return move16() == other.move16(); }
+    bool operator!=(const PackedMove& other) const { return move16() != other.move16(); }
+};
+
+// 快速走子的撤销记录，由调用方保存在栈上
+struct UndoInfo {
+    PackedMove move;     // 已执行的走法（含走子与被吃子）
+};
+
+// 定长走法列表：在栈上分配，避免搜索中的堆分配
+// 单个局面的伪合法走法数不超过120，MAX_MOVES留有余量
+class MoveList {
+public:
+    static const int MAX_MOVES = 128;
+    
+    MoveList() : count(0) {}
+    
+    void push_back(const Move& move) {
+        if (count < MAX_MOVES) {
+            new (&data()[count++]) Move(move);
+        }
+    }
+    void clear() { count = 0; }
+    void resize(int newSize) { count = newSize; }
+    int size() const { return count; }
+    bool empty() const { return count == 0; }
+    
+    Move& operator[](int index) { return data()[index]; }
+    const Move& operator[](int index) const { return data()[index]; }
+    
+    Move* begin() { return data(); }
+    Move* end() { return data() + count; }
+    const Move* begin() const { return data(); }
+    const Move* end() const { return data() + count; }
+    
+private:
+    // 原始存储，避免每次构造时初始化全部元素
+    alignas(Move) unsigned char storage[MAX_MOVES * sizeof(Move)];
+    int count;
+    
+    Move* data() { return reinterpret_cast<Move*>(storage); }
+    const Move* data() const { return reinterpret_cast<const Move*>(storage); }
+};
+
+// 90位棋盘位图（格点编号 square = row * 9 + col，取值0..89）
+struct Bitboard {
+    uint64_t lo;    // 第0..63格
+    uint64_t hi;    // 第64..89格
+    
+    Bitboard() : lo(0), hi(0) {}
+    Bitboard(uint64_t l, uint64_t h) : lo(l), hi(h) {}
+    
+    bool test(int sq) const { return sq < 64 ? ((lo >> sq) & 1) != 0 : ((hi >> (sq - 64)) & 1) != 0; }
+    void set(int sq) { if (sq < 64) lo |= 1ULL << sq; else hi |= 1ULL << (sq - 64); }
+    void reset(int sq) { if (sq < 64) lo &= ~(1ULL << sq); else hi &= ~(1ULL << (sq - 64)); }
+    bool any() const { return (lo | hi) != 0; }
+    int count() const { return popCount(lo) + popCount(hi); }
+    
+    // 最低位格点（调用前需保证非空）
+    int lowest() const { return lo ? bitScan(lo) : 64 + bitScan(hi); }
+    int popLowest() { int sq = lowest(); reset(sq); return sq; }
+    
+    Bitboard operator&(const Bitboard& o) const { return Bitboard(lo & o.lo, hi & o.hi); }
+    Bitboard operator|(const Bitboard& o) const { return Bitboard(lo | o.lo, hi | o.hi); }
+    Bitboard operator^(const Bitboard& o) const { return Bitboard(lo ^ o.lo, hi ^ o.hi); }
+    Bitboard& operator|=(const Bitboard& o) { lo |= o.lo; hi |= o.hi; return *this; }
+    Bitboard& operator&=(const Bitboard& o) { lo &= o.lo; hi &= o.hi; return *this; }
+    
+    // 编号在[first, last]区间内的所有格点
+    static Bitboard range(int first, int last) {
+        if (first > last) return Bitboard();
+        return upTo(last + 1) ^ upTo(first);
+    }
+    
+private:
+    // 编号小于n的所有格点
+    static Bitboard upTo(int n) {
+        if (n <= 0) return Bitboard();
+        if (n < 64) return Bitboard((1ULL << n) - 1, 0);
+        if (n == 64) return Bitboard(~0ULL, 0);
+        return Bitboard(~0ULL, (1ULL << (n - 64)) - 1);
+    }
+    
+    static int popCount(uint64_t x) {
+#ifdef _MSC_VER
+        return static_cast<int>(__popcnt64(x));
+#else
+        return __builtin_popcountll(x);
+#endif
+    }
+    
+    static int bitScan(uint64_t x) {
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanForward64(&index, x);
+        return static_cast<int>(index);
+#else
+        return __builtin_ctzll(x);
+#endif
+    }
+};
+
+// 攻击图：双方对每个格点的攻击（含保护）次数及车马炮的伪合法走法数，评估时每个局面只建一次
+struct AttackMap {
+    uint8_t count[2][90];   // [阵营][格点]，阵营0为红方
+    int mobility[2];        // 车、马、炮的伪合法走法数（不检查送将）
+    
+    bool attacked(bool byRed, int square) const { return count[byRed ? 0 : 1][square] != 0; }
+};
+
 // 象棋引擎类
 class ChessEngine {
 public:
@@ -43,12 +205,43 @@ public:
     // 生成所有合法走法
     std::vector<Move> generateLegalMoves(bool forRed = true) const;
     
+    // 生成合法走法到调用方提供的列表（搜索中使用，不分配内存）
+    void generateLegalMoves(bool forRed, MoveList& moves) const;
+    void generateLegalCaptures(bool forRed, MoveList& moves) const;
+    // 可能将军的合法不吃子走法（起点或终点在对方将附近），是否将军仍需givesCheck确认
+    void generateQuietCheckCandidates(bool forRed, MoveList& moves) const;
+    
     // 执行走法
     bool makeMove(const Move& move);
     
     // 撤销走法
     bool undoMove();
     
+    // 搜索专用：走法必须来自generateLegalMoves，不做合法性验证也不记录走法历史
+    void makeMoveUnchecked(const Move& move, UndoInfo& undo);
+    void unmakeMove(const UndoInfo& undo);
+    
+    // 空着：只交换走棋方（供空着裁剪使用），必须成对调用
+    void makeNullMove();
+    void unmakeNullMove();
+    
+    // 重复局面：只在最近一次吃子或走兵之后的局面中查找
+    int getRepetitionCount() const;                // 当前局面此前出现的次数
+    RepetitionType getRepetitionType() const;      // 与上一次出现之间的循环按长将、长捉规则裁决
+    
+    // 从目标格反向探测：byRed一方是否有棋子能走到该格
+    bool isSquareAttacked(int square, bool byRed) const;
+    
+    // 静态交换评估：双方轮流以价值最小的棋子在目标格上吃子后，走子方的净得子价值
+    // 计入炮架变化、蹩马腿和将帅对面，不考虑其他牵制
+    int staticExchange(const Move& move) const;
+    
+    // 走法是否将军（不执行走法，只做局部探测）
+    bool givesCheck(const Move& move) const;
+    
+    // 建立攻击图（只看射线、炮架、马腿与象眼，不检查送将），供评估使用
+    void buildAttackMap(AttackMap& map) const;
+    
     // 检查将军/将死
     bool isInCheck(bool isRed) const;
     bool isCheckmate(bool isRed) const;
@@ -60,7 +253,19 @@ public:
     
     // 获取当前轮到谁下棋
     bool isRedTurn() const { return redToMove; }
-    void setRedTurn(bool red) { redToMove = red; }
+    void setRedTurn(bool red) { if (red != redToMove) { flipSide(); resetPositionHistory(); } }
+    
+    // Zobrist哈希值（含轮走方），随走子增量更新
+    uint64_t getHashKey() const { return hashKey; }
+    // 不含轮走方的哈希值，用于与轮走方无关的评估缓存
+    uint64_t getBoardKey() const;
+    
+    // 仅由兵卒位置组成的哈希值，用于兵型评估缓存
+    uint64_t getPawnKey() const { return pawnKey; }
+    
+    // 子力与位置分（红方视角，见PieceSquareTable），随走子增量更新
+    int getMaterialScore() const { return materialScore; }
+    void refreshMaterialScore();
     
     // FEN字符串支持
     std::string toFEN() const;
@@ -76,15 +281,70 @@ public:
     void copyBoard(PieceType destBoard[10][9]) const;
     void setBoard(const PieceType srcBoard[10][9]);
     
-private:
+    // 位图与棋子列表（随棋盘增量维护）
+    static int squareOf(int row, int col) { return row * BOARD_COLS + col; }
+    static int rowOf(int square) { return square / BOARD_COLS; }
+    static int colOf(int square) { return square % BOARD_COLS; }
+    
+    int getKingSquare(bool red) const { return kingSquare[red ? 0 : 1]; }
+    const Bitboard& getPieceBitboard(PieceType piece) const { return pieceBB[piece]; }
+    const Bitboard& getSideBitboard(bool red) const { return sideBB[red ? 0 : 1]; }
+    const Bitboard& getOccupied() const { return occupiedBB; }
+    int getPieceCount(bool red) const { return pieceCount[red ? 0 : 1]; }
+    int getPieceSquare(bool red, int index) const { return pieceList[red ? 0 : 1][index]; }
+    
+    // 同一行/列上两格之间（不含两端）的格点
+    static Bitboard betweenMask(int fromSquare, int toSquare);
+    // 该格所在纵线上朝对方底线方向（不含该格）的格点
+    static Bitboard aheadMask(int square, bool red);
+    
     static const int BOARD_ROWS = 10;
     static const int BOARD_COLS = 9;
+    static const int BOARD_SIZE = BOARD_ROWS * BOARD_COLS;
     
+private:
     PieceType board[BOARD_ROWS][BOARD_COLS];
     std::vector<Move> moveHistory;
     bool redToMove;
+    uint64_t hashKey;
+    uint64_t pawnKey;
+    int materialScore;
+    
+    // 位图：按棋子类型、按阵营及全部占位
+    Bitboard pieceBB[15];
+    Bitboard sideBB[2];
+    Bitboard occupiedBB;
+    
+    // 棋子列表：每方棋子所在格点，pieceIndex为格点在列表中的下标
+    uint8_t pieceList[2][BOARD_SIZE];
+    uint8_t pieceIndex[BOARD_SIZE];
+    int pieceCount[2];
+    int kingSquare[2];      // 帅/将位置，-1表示不在棋盘上
+    
+    // 局面历史（含搜索中的走法），用于重复局面检测
+    struct PositionRecord {
+        uint64_t key;           // 走子后的局面键值
+        PackedMove move;        // 到达该局面的走法，起始局面与空着为无效走法
+        int reversiblePlies;    // 距最近一次吃子、走兵或空着的步数
+    };
+    std::vector<PositionRecord> positionHistory;
+    
+    static Bitboard fileMasks[BOARD_COLS];
+    
+    // 增量维护位图与棋子列表的底层操作
+    void addPiece(int square, PieceType piece);
+    void removePiece(int square);
+    void movePiece(int fromSquare, int toSquare);
+    void rebuildPieceSets();
+    void flipSide();
+    void pushPosition(PackedMove move);
+    void popPosition();
+    void resetPositionHistory();
+    int findRepetition() const;
+    bool isChasingMove(PackedMove move) const;   // 在走后局面上判断该步是否新捉对方的子
     
     // 辅助函数
+    static int sideOf(PieceType piece) { return piece >= BLACK_KING ? 1 : 0; }
     bool isRed(PieceType piece) const;
     bool isBlack(PieceType piece) const;
     bool isSameColor(PieceType p1, PieceType p2) const;
@@ -105,16 +365,30 @@ private:
     
     // 检查将军
     bool wouldBeInCheck(const Move& move, bool isRed) const;
-    bool isKingFacingKing() const;
+    bool isKingFacingKing(int redKing, int blackKing) const;   // 将帅同列且中间无子
+    
+    // 收集byRed一方能吃到该格的所有棋子所在格，返回数量；
+    // attackers为空时只判断是否受攻击，找到第一个攻击者即返回1
+    int collectAttackers(int square, bool byRed, int attackers[]) const;
+    
+    // 计算本方王所在直线与马腿上的牵制信息：
+    // pinned为移开后可能暴露王的本方棋子，screens为落子后会成为炮架的空格
+    void computeKingShields(bool forRed, Bitboard& pinned, Bitboard& screens) const;
+    
+    // 生成合法走法，按类型只保留吃子或可能将军的不吃子走法
+    enum MoveGenType { GEN_ALL, GEN_CAPTURES, GEN_QUIET_CHECKS };
+    // 格点是否在将所在的横线、纵线或5×5邻域内（将军走法的起点或终点必在其中）
+    static bool isNearKing(int square, int kingSquare);
+    void generateMoves(bool forRed, MoveList& moves, MoveGenType type) const;
     
     // 生成特定棋子的走法
-    void generateKingMoves(int row, int col, std::vector<Move>& moves) const;
-    void generateAdvisorMoves(int row, int col, std::vector<Move>& moves) const;
-    void generateBishopMoves(int row, int col, std::vector<Move>& moves) const;
-    void generateKnightMoves(int row, int col, std::vector<Move>& moves) const;
-    void generateRookMoves(int row, int col, std::vector<Move>& moves) const;
-    void generateCannonMoves(int row, int col, std::vector<Move>& moves) const;
-    void generatePawnMoves(int row, int col, std::vector<Move>& moves) const;
+    void generateKingMoves(int row, int col, MoveList& moves) const;
+    void generateAdvisorMoves(int row, int col, MoveList& moves) const;
+    void generateBishopMoves(int row, int col, MoveList& moves) const;
+    void generateKnightMoves(int row, int col, MoveList& moves) const;
+    void generateRookMoves(int row, int col, MoveList& moves) const;
+    void generateCannonMoves(int row, int col, MoveList& moves) const;
+    void generatePawnMoves(int row, int col, MoveList& moves) const;
 };
 
 #endif // CHESSENGINE_H
\ No newline at end of file
@@ -0,0 +1,37 @@
+#include "EvaluationCache.h"
+
+EvaluationCache::EvaluationCache(size_t entries) {
+    // 项数向下取整到2的幂，便于用掩码定位
+    size_t count = 1;
+    while (count * 2 <= entries) {
+        count *= 2;
+    }
+    
+    this->entries.reset(new Entry[count]);
+    indexMask = count - 1;
+    clear();
+}
+
+void EvaluationCache::clear() {
+    for (size_t i = 0; i <= indexMask; i++) {
+        entries[i].check.store(0, std::memory_order_relaxed);
+        entries[i].data.store(0, std::memory_order_relaxed);
+    }
+}
+
+bool EvaluationCache::probe(uint64_t key, int& value) const {
+    const Entry& entry = entries[key & indexMask];
+    uint64_t data = entry.data.load(std::memory_order_relaxed);
+    uint64_t check = entry.check.load(std::memory_order_relaxed);
+    if (data == 0 || (check ^ data) != key) return false;
+    
+    value = unpack(data);
+    return true;
+}
+
+void EvaluationCache::store(uint64_t key, int value) {
+    Entry& entry = entries[key & indexMask];
+    uint64_t data = pack(value);
+    entry.check.store(key ^ data, std::memory_order_relaxed);
+    entry.data.store(data, std::memory_order_relaxed);
+}
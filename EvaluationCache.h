@@ -0,0 +1,34 @@
+#ifndef EVALUATIONCACHE_H
+#define EVALUATIONCACHE_H
+
+#include <atomic>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+
+// 直接映射的评估缓存：以局面键值的低位定位，每个键值只对应一项，新值直接覆盖旧值。
+// 与置换表相同，每项存data与check = key ^ data两个字，多个搜索线程可无锁共享。
+class EvaluationCache {
+public:
+    explicit EvaluationCache(size_t entries);
+    
+    void clear();
+    
+    bool probe(uint64_t key, int& value) const;
+    void store(uint64_t key, int value);
+    
+private:
+    struct Entry {
+        std::atomic<uint64_t> check;
+        std::atomic<uint64_t> data;
+    };
+    
+    std::unique_ptr<Entry[]> entries;
+    size_t indexMask;
+    
+    // data低32位为评分，第32位恒为1以区分空项
+    static uint64_t pack(int value) { return static_cast<uint32_t>(value) | (1ULL << 32); }
+    static int unpack(uint64_t data) { return static_cast<int32_t>(static_cast<uint32_t>(data)); }
+};
+
+#endif // EVALUATIONCACHE_H
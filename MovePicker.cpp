@@ -0,0 +1,108 @@
+#include "MovePicker.h"
+#include <algorithm>
+#include <cstdlib>
+
+// 排序用的棋子价值（将作为吃子方时记为0，它能吃的子一定没有保护）
+const int MovePicker::ORDER_VALUES[15] = {
+    0,                      // NONE
+    0, 2, 2, 4, 6, 3, 1,    // 红方：帅、仕、相、马、车、炮、兵
+    0, 2, 2, 4, 6, 3, 1     // 黑方：将、士、象、马、车、炮、卒
+};
+
+void SearchHeuristics::clear() {
+    std::fill(&killers[0][0], &killers[0][0] + MAX_PLY * 2, PackedMove());
+    std::fill(&history[0][0][0], &history[0][0][0] + 2 * 90 * 90, 0);
+    std::fill(&counterMoves[0][0], &counterMoves[0][0] + 15 * 90, PackedMove());
+}
+
+void SearchHeuristics::updateHistory(bool red, const Move& move, int bonus) {
+    // 按当前值衰减，使历史分始终落在[-HISTORY_MAX, HISTORY_MAX]内
+    int& entry = history[red ? 0 : 1][ChessEngine::squareOf(move.fromRow, move.fromCol)]
+                        [ChessEngine::squareOf(move.toRow, move.toCol)];
+    entry += bonus - entry * std::abs(bonus) / HISTORY_MAX;
+}
+
+void SearchHeuristics::updateQuietCutoff(bool red, int ply, const Move& move, PackedMove previousMove, int depth,
+                                         const Move* searchedQuiets, int searchedCount) {
+    PackedMove packed(move);
+    if (ply < MAX_PLY && killers[ply][0] != packed) {
+        killers[ply][1] = killers[ply][0];
+        killers[ply][0] = packed;
+    }
+    
+    if (previousMove.isValid()) {
+        counterMoves[previousMove.movingPiece()][previousMove.to()] = packed;
+    }
+    
+    int bonus = std::min(depth * depth, 400);
+    updateHistory(red, move, bonus);
+    for (int i = 0; i < searchedCount; i++) {
+        updateHistory(red, searchedQuiets[i], -bonus);
+    }
+}
+
+MovePicker::MovePicker(const ChessEngine& engine, MoveList& moves, const Move& hashMove,
+                       const SearchHeuristics* heuristics, int ply, PackedMove previousMove)
+    : moves(moves), current(0)
+{
+    PackedMove hashTarget(hashMove);
+    PackedMove killer1, killer2, counter;
+    if (heuristics) {
+        if (ply < SearchHeuristics::MAX_PLY) {
+            killer1 = heuristics->killers[ply][0];
+            killer2 = heuristics->killers[ply][1];
+        }
+        if (previousMove.isValid()) {
+            counter = heuristics->counterMoves[previousMove.movingPiece()][previousMove.to()];
+        }
+    }
+    
+    // 每个走法只评分一次
+    for (int i = 0; i < moves.size(); i++) {
+        const Move& move = moves[i];
+        PackedMove packed(move);
+        PieceType moving = engine.getPiece(move.fromRow, move.fromCol);
+        PieceType captured = engine.getPiece(move.toRow, move.toCol);
+        
+        if (hashTarget.isValid() && packed == hashTarget) {
+            scores[i] = HASH_MOVE_SCORE;
+        } else if (captured != NONE) {
+            // 静态交换评估亏子的吃子放到安静走法之后（以大吃小不会亏，无需计算）
+            bool losing = ORDER_VALUES[captured] < ORDER_VALUES[moving] && engine.staticExchange(move) < 0;
+            scores[i] = (losing ? BAD_CAPTURE_SCORE : GOOD_CAPTURE_SCORE) + captureScore(captured, moving);
+        } else if (!heuristics) {
+            scores[i] = 0;
+        } else if (packed == killer1) {
+            scores[i] = KILLER_SCORE + 2;
+        } else if (packed == killer2) {
+            scores[i] = KILLER_SCORE + 1;
+        } else if (packed == counter) {
+            scores[i] = KILLER_SCORE;
+        } else {
+            scores[i] = heuristics->getHistory(moving < BLACK_KING, move);
+        }
+    }
+}
+
+bool MovePicker::next(Move& move) {
+    if (current >= moves.size()) return false;
+    
+    // 选择排序：只在需要时找出剩余走法中分数最高的一个，截断后无需再排后面的走法
+    int best = current;
+    for (int i = current + 1; i < moves.size(); i++) {
+        if (scores[i] > scores[best]) {
+            best = i;
+        }
+    }
+    if (best != current) {
+        std::swap(moves[best], moves[current]);
+        std::swap(scores[best], scores[current]);
+    }
+    
+    move = moves[current++];
+    return true;
+}
+
+int MovePicker::captureScore(PieceType captured, PieceType moving) {
+    return ORDER_VALUES[captured] * 16 - ORDER_VALUES[moving];
+}
@@ -0,0 +1,61 @@
+#ifndef MOVEPICKER_H
+#define MOVEPICKER_H
+
+#include "ChessEngine.h"
+
+// 走法排序启发表（每个搜索线程一份）
+struct SearchHeuristics {
+    static constexpr int MAX_PLY = 128;
+    static constexpr int HISTORY_MAX = 16384;
+    
+    PackedMove killers[MAX_PLY][2];     // 每层两个杀手走法
+    int history[2][90][90];             // 历史表：走棋方×起点×终点
+    PackedMove counterMoves[15][90];    // 应着表：以对方上一步的棋子和终点为索引
+    
+    SearchHeuristics() { clear(); }
+    void clear();
+    
+    // 安静走法产生截断时调用：更新杀手、应着，并奖励该走法、惩罚之前搜索过的安静走法
+    void updateQuietCutoff(bool red, int ply, const Move& move, PackedMove previousMove, int depth,
+                           const Move* searchedQuiets, int searchedCount);
+    
+    int getHistory(bool red, const Move& move) const {
+        return history[red ? 0 : 1][ChessEngine::squareOf(move.fromRow, move.fromCol)]
+                      [ChessEngine::squareOf(move.toRow, move.toCol)];
+    }
+    
+private:
+    void updateHistory(bool red, const Move& move, int bonus);
+};
+
+// 分阶段走法选择器：每个走法只评分一次，之后按分数逐个取出
+// 分数按阶段分段：置换表走法 > 好的吃子 > 杀手走法与应着 > 按历史分排序的安静走法 > 坏的吃子
+// 好坏吃子由静态交换评估区分
+class MovePicker {
+public:
+    // heuristics为空时只按吃子价值排序（静态搜索使用）
+    MovePicker(const ChessEngine& engine, MoveList& moves, const Move& hashMove,
+               const SearchHeuristics* heuristics = nullptr, int ply = 0, PackedMove previousMove = PackedMove());
+    
+    bool next(Move& move);
+    
+    // 最近取出的走法是否为静态交换评估亏子的吃子
+    bool pickedBadCapture() const { return current > 0 && scores[current - 1] < BAD_CAPTURE_SCORE / 2; }
+    
+    // 按吃子价值（MVV-LVA）计算的吃子排序分
+    static int captureScore(PieceType captured, PieceType moving);
+    
+private:
+    static const int HASH_MOVE_SCORE = 1 << 30;
+    static const int GOOD_CAPTURE_SCORE = 1 << 28;
+    static const int KILLER_SCORE = 1 << 26;
+    static const int BAD_CAPTURE_SCORE = -(1 << 28);
+    
+    MoveList& moves;
+    int scores[MoveList::MAX_MOVES];
+    int current;
+    
+    static const int ORDER_VALUES[15];
+};
+
+#endif // MOVEPICKER_H
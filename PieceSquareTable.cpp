@@ -0,0 +1,179 @@
+#include "PieceSquareTable.h"
+#include <fstream>
+#include <sstream>
+
+const char* const PieceSquareTable::PIECE_NAMES[PIECE_KINDS] = {
+    "king", "advisor", "bishop", "knight", "rook", "cannon", "pawn"
+};
+
+// 帅（将）始终在棋盘上，子力价值记为0
+const int PieceSquareTable::DEFAULT_MATERIAL[PIECE_KINDS] = {
+    0, 200, 200, 400, 600, 300, 100
+};
+
+// 红方视角的位置分，第0行为黑方底线，第9行为红方底线
+const int PieceSquareTable::DEFAULT_POSITION[PIECE_KINDS][90] = {
+    // 帅：离开底线会暴露在对方攻击之下
+    {
+         0,   0,   0,   0,   0,   0,   0,   0,   0,
+         0,   0,   0,   0,   0,   0,   0,   0,   0,
+         0,   0,   0,   0,   0,   0,   0,   0,   0,
+         0,   0,   0,   0,   0,   0,   0,   0,   0,
+         0,   0,   0,   0,   0,   0,   0,   0,   0,
+         0,   0,   0,   0,   0,   0,   0,   0,   0,
+         0,   0,   0,   0,   0,   0,   0,   0,   0,
+         0,   0,   0, -16, -18, -16,   0,   0,   0,
+         0,   0,   0,  -8, -10,  -8,   0,   0,   0,
+         0,   0,   0,  -2,   0,  -2,   0,   0,   0
+    },
+    // 仕：守在九宫中心最好
+    {
+         0,   0,   0,   0,   0,   0,   0,   0,   0,
+         0,   0,   0,   0,   0,   0,   0,   0,   0,
+         0,   0,   0,   0,   0,   0,   0,   0,   0,
+         0,   0,   0,   0,   0,   0,   0,   0,   0,
+         0,   0,   0,   0,   0,   0,   0,   0,   0,
+         0,   0,   0,   0,   0,   0,   0,   0,   0,
+         0,   0,   0,   0,   0,   0,   0,   0,   0,
+         0,   0,   0,  -2,   0,  -2,   0,   0,   0,
+         0,   0,   0,   0,   4,   0,   0,   0,   0,
+         0,   0,   0,   0,   0,   0,   0,   0,   0
+    },
+    // 相：中相最稳，边相较弱
+    {
+         0,   0,   0,   0,   0,   0,   0,   0,   0,
+         0,   0,   0,   0,   0,   0,   0,   0,   0,
+         0,   0,   0,   0,   0,   0,   0,   0,   0,
+         0,   0,   0,   0,   0,   0,   0,   0,   0,
+         0,   0,   0,   0,   0,   0,   0,   0,   0,
+         0,   0,  -2,   0,   0,   0,  -2,   0,   0,
+         0,   0,   0,   0,   0,   0,   0,   0,   0,
+        -2,   0,   0,   0,   4,   0,   0,   0,  -2,
+         0,   0,   0,   0,   0,   0,   0,   0,   0,
+         0,   0,   0,   0,   0,   0,   0,   0,   0
+    },
+    // 马：过河后靠近九宫最活跃，困在底线与边路较弱
+    {
+         4,   8,  16,  12,   4,  12,  16,   8,   4,
+         4,  10,  28,  16,   8,  16,  28,  10,   4,
+        12,  14,  16,  20,  18,  20,  16,  14,  12,
+         8,  24,  18,  24,  20,  24,  18,  24,   8,
+         6,  16,  14,  18,  16,  18,  14,  16,   6,
+         4,  12,  16,  14,  12,  14,  16,  12,   4,
+         2,   6,   8,   6,  10,   6,   8,   6,   2,
+         4,   2,   8,   8,   4,   8,   8,   2,   4,
+         0,   2,   4,   4,  -2,   4,   4,   2,   0,
+         0,  -4,   0,   0,   0,   0,   0,  -4,   0
+    },
+    // 车：占据肋道与对方卒林线、下二路最有力
+    {
+        14,  14,  12,  18,  16,  18,  12,  14,  14,
+        16,  20,  18,  24,  26,  24,  18,  20,  16,
+        12,  12,  12,  18,  18,  18,  12,  12,  12,
+        12,  18,  16,  22,  22,  22,  16,  18,  12,
+        12,  14,  12,  18,  18,  18,  12,  14,  12,
+        12,  16,  14,  20,  20,  20,  14,  16,  12,
+         6,  10,   8,  14,  14,  14,   8,  10,   6,
+         4,   8,   6,  14,  12,  14,   6,   8,   4,
+         8,   4,   8,  16,   8,  16,   8,   4,   8,
+        -2,  10,   6,  14,  12,  14,   6,  10,  -2
+    },
+    // 炮：中炮与沉底炮有威胁，进入对方九宫后容易失去炮架
+    {
+         6,   4,   0, -10, -12, -10,   0,   4,   6,
+         2,   2,   0,  -4, -14,  -4,   0,   2,   2,
+         2,   2,   0, -10,  -8, -10,   0,   2,   2,
+         0,   0,  -2,   4,  10,   4,  -2,   0,   0,
+         0,   0,   0,   2,   8,   2,   0,   0,   0,
+        -2,   0,   4,   2,   6,   2,   4,   0,  -2,
+         0,   0,   0,   2,   4,   2,   0,   0,   0,
+         4,   0,   8,   6,  10,   6,   8,   0,   4,
+         0,   2,   4,   6,   6,   6,   4,   2,   0,
+         0,   0,   2,   6,   6,   6,   2,   0,   0
+    },
+    // 兵：过河后价值大增，逼近九宫最强，沉底后作用减小
+    {
+         0,   3,   6,   9,  12,   9,   6,   3,   0,
+        18,  36,  56,  80, 120,  80,  56,  36,  18,
+        14,  26,  42,  60,  80,  60,  42,  26,  14,
+        10,  20,  30,  34,  40,  34,  30,  20,  10,
+         6,  12,  18,  18,  20,  18,  18,  12,   6,
+         2,   0,   8,   0,   8,   0,   8,   0,   2,
+         0,   0,  -2,   0,   4,   0,  -2,   0,   0,
+         0,   0,   0,   0,   0,   0,   0,   0,   0,
+         0,   0,   0,   0,   0,   0,   0,   0,   0,
+         0,   0,   0,   0,   0,   0,   0,   0,   0
+    }
+};
+
+int PieceSquareTable::values[15][90];
+int PieceSquareTable::material[PIECE_KINDS];
+int PieceSquareTable::position[PIECE_KINDS][90];
+
+// 程序启动时载入内置表
+static const bool defaultTablesLoaded = (PieceSquareTable::resetToDefault(), true);
+
+void PieceSquareTable::build(const int newMaterial[PIECE_KINDS], const int newPosition[PIECE_KINDS][90]) {
+    for (int sq = 0; sq < 90; sq++) {
+        values[0][sq] = 0;
+    }
+    
+    // 红方棋子下标为1~7，黑方为8~14，黑方取上下翻转后的格点并取负
+    for (int kind = 0; kind < PIECE_KINDS; kind++) {
+        material[kind] = newMaterial[kind];
+        for (int sq = 0; sq < 90; sq++) {
+            int mirrored = (9 - sq / 9) * 9 + sq % 9;
+            position[kind][sq] = newPosition[kind][sq];
+            values[1 + kind][sq] = newMaterial[kind] + newPosition[kind][sq];
+            values[8 + kind][sq] = -(newMaterial[kind] + newPosition[kind][mirrored]);
+        }
+    }
+}
+
+void PieceSquareTable::resetToDefault() {
+    build(DEFAULT_MATERIAL, DEFAULT_POSITION);
+}
+
+bool PieceSquareTable::loadFromFile(const std::string& filename) {
+    std::ifstream file(filename);
+    if (!file.is_open()) return false;
+    
+    // 去掉注释后按空白分隔读取
+    std::stringstream content;
+    std::string line;
+    while (std::getline(file, line)) {
+        if (!line.empty() && line[0] == '#') continue;
+        content << line << '\n';
+    }
+    
+    int newMaterial[PIECE_KINDS];
+    int newPosition[PIECE_KINDS][90];
+    for (int kind = 0; kind < PIECE_KINDS; kind++) {
+        std::string name;
+        if (!(content >> name) || name != PIECE_NAMES[kind]) return false;
+        if (!(content >> newMaterial[kind])) return false;
+        for (int sq = 0; sq < 90; sq++) {
+            if (!(content >> newPosition[kind][sq])) return false;
+        }
+    }
+    
+    build(newMaterial, newPosition);
+    return true;
+}
+
+bool PieceSquareTable::saveToFile(const std::string& filename) {
+    std::ofstream file(filename);
+    if (!file.is_open()) return false;
+    
+    file << "# 名称 子力价值，随后为红方视角的10行x9列位置分（第0行为黑方底线）\n";
+    for (int kind = 0; kind < PIECE_KINDS; kind++) {
+        file << PIECE_NAMES[kind] << ' ' << material[kind] << '\n';
+        for (int row = 0; row < 10; row++) {
+            for (int col = 0; col < 9; col++) {
+                file << (col ? " " : "") << position[kind][row * 9 + col];
+            }
+            file << '\n';
+        }
+    }
+    return file.good();
+}
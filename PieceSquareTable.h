@@ -0,0 +1,36 @@
+#ifndef PIECESQUARETABLE_H
+#define PIECESQUARETABLE_H
+
+#include <string>
+
+// 子力与位置价值表：每种棋子在每个格点上的价值（子力价值加位置分），
+// 红方为正、黑方为负，由ChessEngine在走子时增量累加。
+// 棋子下标与PieceType一致，格点为 行*9+列。
+// 表为全局共享，重新加载后需对已有局面调用ChessEngine::refreshMaterialScore，且不能在搜索时加载。
+class PieceSquareTable {
+public:
+    static int value(int piece, int square) { return values[piece][square]; }
+    
+    // 恢复内置的价值表
+    static void resetToDefault();
+    
+    // 文本格式：依次为帅、仕、相、马、车、炮、兵，每种棋子先写名称和子力价值，
+    // 再写红方视角（第0行为黑方底线）的10行×9列位置分，#开头的行为注释。
+    // 黑方的表由红方上下翻转得到。读取失败时保持原表不变。
+    static bool loadFromFile(const std::string& filename);
+    static bool saveToFile(const std::string& filename);
+    
+private:
+    static const int PIECE_KINDS = 7;
+    static const char* const PIECE_NAMES[PIECE_KINDS];
+    static const int DEFAULT_MATERIAL[PIECE_KINDS];
+    static const int DEFAULT_POSITION[PIECE_KINDS][90];
+    
+    static int values[15][90];
+    static int material[PIECE_KINDS];         // 当前表的子力价值与位置分，用于保存
+    static int position[PIECE_KINDS][90];
+    
+    static void build(const int newMaterial[PIECE_KINDS], const int newPosition[PIECE_KINDS][90]);
+};
+
+#endif // PIECESQUARETABLE_H
@@ -0,0 +1,49 @@
+#include "TimeManager.h"
+#include <algorithm>
+
+TimeManager::TimeManager()
+    : startTime(std::chrono::steady_clock::now()), softLimit(0.0), hardLimit(0.0), stableIterations(0)
+{
+}
+
+void TimeManager::start(const TimeControl& control, double moveTimeLimit) {
+    startTime = std::chrono::steady_clock::now();
+    stableIterations = 0;
+    
+    // 固定时限下，用时过半后开始的迭代通常来不及完成
+    hardLimit = moveTimeLimit;
+    softLimit = moveTimeLimit * 0.5;
+    
+    if (control.remaining > 0.0) {
+        int movesToGo = control.movesToGo > 0 ? std::min(control.movesToGo, MAX_MOVES_TO_GO) : DEFAULT_MOVES_TO_GO;
+        double usable = std::max(0.0, control.remaining - SAFETY_MARGIN);
+        double base = usable / movesToGo + control.increment * 0.75;
+        
+        softLimit = std::min(softLimit, base);
+        hardLimit = std::min({hardLimit, base * 4, usable * 0.8});
+    }
+    
+    hardLimit = std::max(hardLimit, MIN_HARD_LIMIT);
+    softLimit = std::min(softLimit, hardLimit);
+}
+
+double TimeManager::elapsed() const {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+void TimeManager::onIterationComplete(bool bestMoveChanged) {
+    stableIterations = bestMoveChanged ? 0 : stableIterations + 1;
+}
+
+bool TimeManager::shouldStopAfterIteration() const {
+    // 最佳走法刚变化时多给时间，连续几轮不变时提前结束
+    double factor = 1.0;
+    if (stableIterations == 0) {
+        factor = 1.3;
+    } else if (stableIterations >= 4) {
+        factor = 0.4;
+    } else if (stableIterations >= 2) {
+        factor = 0.7;
+    }
+    return elapsed() >= std::min(softLimit * factor, hardLimit);
+}
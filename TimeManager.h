@@ -0,0 +1,46 @@
+#ifndef TIMEMANAGER_H
+#define TIMEMANAGER_H
+
+#include <chrono>
+
+// 时钟状态（与界面上红黑双方的计时对应）
+struct TimeControl {
+    double remaining;   // 本方剩余时间（秒），不大于0表示不计时
+    double increment;   // 每步加秒
+    int movesToGo;      // 距下一次加时的步数，0表示包干制
+    
+    TimeControl() : remaining(0.0), increment(0.0), movesToGo(0) {}
+};
+
+// 每步用时管理：
+// 软时限用于决定是否开始新一轮迭代，硬时限用于在搜索中途强制停止。
+// 固定的每步时限作为上限，计时模式下再按剩余时间、加秒和步数分配。
+class TimeManager {
+public:
+    TimeManager();
+    
+    void start(const TimeControl& control, double moveTimeLimit);
+    
+    double elapsed() const;
+    double getSoftLimit() const { return softLimit; }
+    double getHardLimit() const { return hardLimit; }
+    
+    // 每完成一轮迭代调用，最佳走法越稳定，越早结束思考
+    void onIterationComplete(bool bestMoveChanged);
+    bool shouldStopAfterIteration() const;
+    
+    bool hardLimitReached() const { return elapsed() >= hardLimit; }
+    
+private:
+    static constexpr int DEFAULT_MOVES_TO_GO = 30;   // 包干制下假定的剩余步数
+    static constexpr int MAX_MOVES_TO_GO = 50;
+    static constexpr double SAFETY_MARGIN = 0.1;     // 为界面与走子预留的时间（秒）
+    static constexpr double MIN_HARD_LIMIT = 0.02;   // 时间将尽时也至少留出搜完浅层的时间
+    
+    std::chrono::steady_clock::time_point startTime;
+    double softLimit;
+    double hardLimit;
+    int stableIterations;
+};
+
+#endif // TIMEMANAGER_H
@@ -0,0 +1,136 @@
+#include "TranspositionTable.h"
+#include <algorithm>
+
+TranspositionTable::TranspositionTable() : bucketCount(0), indexMask(0), generation(0) {
+    resize(16);
+}
+
+void TranspositionTable::resize(size_t megabytes) {
+    if (megabytes < 1) megabytes = 1;
+    
+    // 桶数取不超过指定大小的最大2的幂，便于用掩码定位
+    size_t maxBuckets = megabytes * 1024 * 1024 / sizeof(Bucket);
+    size_t count = 1;
+    while (count * 2 <= maxBuckets) {
+        count *= 2;
+    }
+    
+    buckets.reset(new Bucket[count]);
+    bucketCount = count;
+    indexMask = count - 1;
+    clear();
+}
+
+void TranspositionTable::clear() {
+    for (size_t i = 0; i < bucketCount; i++) {
+        for (int j = 0; j < BUCKET_SIZE; j++) {
+            buckets[i].slots[j].check.store(0, std::memory_order_relaxed);
+            buckets[i].slots[j].data.store(0, std::memory_order_relaxed);
+        }
+    }
+    generation.store(0);
+}
+
+uint64_t TranspositionTable::pack(const TranspositionEntry& entry) {
+    return static_cast<uint64_t>(entry.bestMove.data & 0x3FFFFF)
+         | static_cast<uint64_t>(static_cast<uint16_t>(entry.score)) << 22
+         | static_cast<uint64_t>(static_cast<uint8_t>(entry.depth)) << 38
+         | static_cast<uint64_t>(entry.type & 0x3) << 46
+         | static_cast<uint64_t>(entry.generation & GENERATION_MASK) << 48;
+}
+
+TranspositionEntry TranspositionTable::unpack(uint64_t data) {
+    TranspositionEntry entry;
+    entry.bestMove.data = static_cast<uint32_t>(data & 0x3FFFFF);
+    entry.score = static_cast<int16_t>(static_cast<uint16_t>(data >> 22));
+    entry.depth = static_cast<int8_t>(static_cast<uint8_t>(data >> 38));
+    entry.type = static_cast<TranspositionEntry::NodeType>((data >> 46) & 0x3);
+    entry.generation = static_cast<uint8_t>((data >> 48) & GENERATION_MASK);
+    return entry;
+}
+
+bool TranspositionTable::probe(uint64_t hash, TranspositionEntry& entry) const {
+    const Bucket& bucket = bucketFor(hash);
+    
+    for (int i = 0; i < BUCKET_SIZE; i++) {
+        uint64_t data = bucket.slots[i].data.load(std::memory_order_relaxed);
+        uint64_t check = bucket.slots[i].check.load(std::memory_order_relaxed);
+        if (data != 0 && (check ^ data) == hash) {
+            entry = unpack(data);
+            return true;
+        }
+    }
+    return false;
+}
+
+void TranspositionTable::store(uint64_t hash, int score, int depth, TranspositionEntry::NodeType type, PackedMove bestMove) {
+    Bucket& bucket = bucketFor(hash);
+    uint8_t currentGeneration = generation.load(std::memory_order_relaxed);
+    
+    // 优先覆盖同一局面；否则替换深度最浅、代数最旧的表项
+    Slot* replace = &bucket.slots[0];
+    uint64_t replaceData = 0;
+    bool samePosition = false;
+    int worstValue = 1 << 30;
+    for (int i = 0; i < BUCKET_SIZE; i++) {
+        Slot& slot = bucket.slots[i];
+        uint64_t data = slot.data.load(std::memory_order_relaxed);
+        uint64_t check = slot.check.load(std::memory_order_relaxed);
+        if (data != 0 && (check ^ data) == hash) {
+            replace = &slot;
+            replaceData = data;
+            samePosition = true;
+            break;
+        }
+        
+        TranspositionEntry candidate = unpack(data);
+        int age = (currentGeneration - candidate.generation) & GENERATION_MASK;
+        int value = data == 0 ? -(1 << 20) : candidate.depth - 8 * age;
+        if (value < worstValue) {
+            worstValue = value;
+            replace = &slot;
+            replaceData = data;
+        }
+    }
+    
+    if (samePosition) {
+        TranspositionEntry old = unpack(replaceData);
+        
+        // 同一局面的较深结果不被浅层的非精确结果覆盖
+        if (old.generation == currentGeneration && depth < old.depth && type != TranspositionEntry::EXACT) {
+            return;
+        }
+        
+        // 新结果没有最佳走法时保留原有走法
+        if (!bestMove.isValid()) {
+            bestMove = old.bestMove;
+        }
+    }
+    
+    TranspositionEntry entry;
+    entry.bestMove = bestMove;
+    entry.score = static_cast<int16_t>(score);
+    entry.depth = static_cast<int8_t>(depth);
+    entry.type = type;
+    entry.generation = currentGeneration;
+    
+    uint64_t data = pack(entry);
+    replace->check.store(hash ^ data, std::memory_order_relaxed);
+    replace->data.store(data, std::memory_order_relaxed);
+}
+
+int TranspositionTable::hashfull() const {
+    uint8_t currentGeneration = generation.load(std::memory_order_relaxed);
+    size_t sampleBuckets = std::min<size_t>(1000 / BUCKET_SIZE, bucketCount);
+    
+    int used = 0;
+    for (size_t i = 0; i < sampleBuckets; i++) {
+        for (int j = 0; j < BUCKET_SIZE; j++) {
+            uint64_t data = buckets[i].slots[j].data.load(std::memory_order_relaxed);
+            if (data != 0 && unpack(data).generation == currentGeneration) {
+                used++;
+            }
+        }
+    }
+    return static_cast<int>(used * 1000 / (sampleBuckets * BUCKET_SIZE));
+}
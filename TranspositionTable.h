@@ -0,0 +1,71 @@
+#ifndef TRANSPOSITIONTABLE_H
+#define TRANSPOSITIONTABLE_H
+
+#include "ChessEngine.h"
+#include <atomic>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+
+// 置换表项（解码后的视图）
+struct TranspositionEntry {
+    enum NodeType : uint8_t { EXACT, LOWER_BOUND, UPPER_BOUND };
+    
+    PackedMove bestMove; // 最佳走法（紧凑编码）
+    int16_t score;       // 评分
+    int8_t depth;        // 搜索深度
+    NodeType type;       // 评分类型
+    uint8_t generation;  // 写入时的搜索代数
+    
+    TranspositionEntry() : score(0), depth(0), type(EXACT), generation(0) {}
+};
+
+// 无锁置换表：多个搜索线程共享同一张表而无需加锁
+// 每项由两个64位字组成：data为打包后的表项，check = hash ^ data。
+// 读取时只有 check ^ data == hash 才认为命中，被并发写坏的表项会自然校验失败。
+// 桶数为2的幂，每桶4项恰好占一条64字节缓存行。
+class TranspositionTable {
+public:
+    TranspositionTable();
+    
+    // 按MB设置大小（向下取整到2的幂个桶），会清空表
+    void resize(size_t megabytes);
+    size_t getSizeMB() const { return bucketCount * sizeof(Bucket) / (1024 * 1024); }
+    
+    void clear();
+    
+    // 每次新搜索开始时调用，旧代数的表项优先被替换
+    void newSearch() { generation.store(static_cast<uint8_t>((generation.load() + 1) & GENERATION_MASK)); }
+    
+    bool probe(uint64_t hash, TranspositionEntry& entry) const;
+    void store(uint64_t hash, int score, int depth, TranspositionEntry::NodeType type, PackedMove bestMove);
+    
+    // 采样前1000项中本次搜索写入的比例（千分比）
+    int hashfull() const;
+    
+private:
+    static const int BUCKET_SIZE = 4;
+    static const int GENERATION_MASK = 0x3F;
+    
+    struct Slot {
+        std::atomic<uint64_t> check;
+        std::atomic<uint64_t> data;
+    };
+    
+    struct alignas(64) Bucket {
+        Slot slots[BUCKET_SIZE];
+    };
+    
+    std::unique_ptr<Bucket[]> buckets;
+    size_t bucketCount;
+    size_t indexMask;
+    std::atomic<uint8_t> generation;
+    
+    Bucket& bucketFor(uint64_t hash) const { return buckets[hash & indexMask]; }
+    
+    // data布局：bit 0-21 走法，22-37 评分，38-45 深度，46-47 类型，48-53 代数
+    static uint64_t pack(const TranspositionEntry& entry);
+    static TranspositionEntry unpack(uint64_t data);
+};
+
+#endif // TRANSPOSITIONTABLE_H